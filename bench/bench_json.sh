@@ -0,0 +1,15 @@
+#!/bin/sh
+# runs drivehub_bench and writes the results to bench-<commit>.json, tagged with commit and date
+# usage: bench_json.sh <drivehub_bench> <output dir> [benchmark options]
+set -e
+bench="$1"
+out="$2"
+shift 2
+revision=$(git -C "$(dirname "$0")" rev-parse --short HEAD 2>/dev/null || echo unknown)
+if ! git -C "$(dirname "$0")" diff --quiet HEAD 2>/dev/null; then
+    revision="$revision-dirty"
+fi
+"$bench" --benchmark_repetitions=5 --benchmark_report_aggregates_only=true \
+    --benchmark_context=revision="$revision" \
+    --benchmark_out="$out/bench-$revision.json" --benchmark_out_format=json "$@"
+echo "wrote $out/bench-$revision.json"
@@ -0,0 +1,61 @@
+#include "crc.h"
+#include "legacy.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> makeMessage(size_t len) {
+    std::vector<uint8_t> msg(len);
+    for (size_t i = 0; i < len; i++) {
+        msg[i] = (uint8_t)(i * 131 + 17);
+    }
+    return msg;
+}
+
+void BM_Crc16Legacy(benchmark::State& state) {
+    auto msg = makeMessage(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(legacy::crc16(msg.data(), msg.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * msg.size());
+}
+
+void BM_Crc16Slicing8(benchmark::State& state) {
+    auto msg = makeMessage(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crc16Slicing8(0, ByteSpan(msg.data(), msg.size())));
+    }
+    state.SetBytesProcessed(state.iterations() * msg.size());
+}
+
+void BM_Crc16Clmul(benchmark::State& state) {
+    if (!crc16ClmulSupported()) {
+        state.SkipWithError("no carry-less multiply on this cpu");
+        return;
+    }
+    auto msg = makeMessage(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crc16Clmul(0, ByteSpan(msg.data(), msg.size())));
+    }
+    state.SetBytesProcessed(state.iterations() * msg.size());
+}
+
+void BM_Crc16Dispatch(benchmark::State& state) {
+    auto msg = makeMessage(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crc16(ByteSpan(msg.data(), msg.size())));
+    }
+    state.SetBytesProcessed(state.iterations() * msg.size());
+}
+
+} // namespace
+
+// SUMD frame with 8 channels, VESC status reply, largest short VESC frame, config reply, log replay block
+#define CRC_SIZES ->Arg(21)->Arg(23)->Arg(255)->Arg(1024)->Arg(64 * 1024)
+BENCHMARK(BM_Crc16Legacy) CRC_SIZES;
+BENCHMARK(BM_Crc16Slicing8) CRC_SIZES;
+BENCHMARK(BM_Crc16Clmul) CRC_SIZES;
+BENCHMARK(BM_Crc16Dispatch) CRC_SIZES;
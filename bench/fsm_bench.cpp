@@ -0,0 +1,102 @@
+#include "context.hpp"
+#include "drive_core.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+namespace {
+
+/// entry and exit actions print; keeps them off the benchmark output
+class MuteStdout {
+public:
+    MuteStdout() {
+        fflush(stdout);
+        saved_ = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    }
+    ~MuteStdout() {
+        fflush(stdout);
+        dup2(saved_, STDOUT_FILENO);
+        close(saved_);
+    }
+private:
+    int saved_;
+};
+
+/// the FSM without serial ports. Setpoints go nowhere, prints of the states go to /dev/null
+struct Car {
+    MuteStdout mute;
+    std::shared_ptr<SwiftRobotClient> swiftrobotclient;
+    std::shared_ptr<Vesc> vesc = std::make_shared<Vesc>([](ByteSpan payload) { benchmark::DoNotOptimize(payload.data()); });
+    std::shared_ptr<Receiver> receiver = std::make_shared<Receiver>();
+    std::shared_ptr<LEDController> ledcontroller = std::make_shared<LEDController>();
+    Context context{StateId::setup, swiftrobotclient, vesc, receiver, ledcontroller};
+
+    Car() {
+        context.swiftrobotConnected = true;
+        context.manualControl();
+        context.receiverMotorReset();
+    }
+};
+
+// a signal without a transition in the current state: one table lookup
+void BM_FsmSignalIgnored(benchmark::State& state) {
+    Car car;
+    for (auto _ : state) {
+        car.context.receiverConnected();
+        benchmark::ClobberMemory();
+    }
+    if (car.context.stateId() != StateId::manualControl) {
+        state.SkipWithError("left manual control");
+    }
+}
+
+// a transition whose guard rejects it
+void BM_FsmSignalGuarded(benchmark::State& state) {
+    Car car;
+    car.context.swiftrobotConnected = false;
+    for (auto _ : state) {
+        car.context.lateralControl();
+        benchmark::ClobberMemory();
+    }
+}
+
+// manual control <-> lateral control, with exit and entry actions (LED updates)
+void BM_FsmTransition(benchmark::State& state) {
+    Car car;
+    for (auto _ : state) {
+        car.context.lateralControl();
+        car.context.manualControl();
+        car.context.receiverMotorReset();
+    }
+    state.SetItemsProcessed(state.iterations() * 3);
+}
+
+// one control loop tick with a fresh receiver packet: mailbox, FSM update and both setpoints
+void BM_DriveCoreTick(benchmark::State& state) {
+    Car car;
+    int64_t now = 0;
+    DriveCore core(car.context, [&]() { return now; });
+    ReceiverPacket packet;
+    packet.throttle = 0.3;
+    packet.steering = 0.6;
+    packet.gearSelector = drive;
+    for (auto _ : state) {
+        now += 5000000;
+        packet.timestampNs = now - 100000;
+        core.receiverInput(packet);
+        core.tick();
+    }
+}
+
+}
+
+BENCHMARK(BM_FsmSignalIgnored);
+BENCHMARK(BM_FsmSignalGuarded);
+BENCHMARK(BM_FsmTransition);
+BENCHMARK(BM_DriveCoreTick);
@@ -0,0 +1,46 @@
+#include "latency_histogram.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+// spread over a few hundred buckets, like tick jitter
+std::vector<int64_t> makeLatencies() {
+    std::vector<int64_t> latencies(1024);
+    uint64_t x = 88172645463325252ULL;
+    for (auto& latency : latencies) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        latency = 50000 + (int64_t)(x % 5000000);
+    }
+    return latencies;
+}
+
+// cost added to every control loop tick which passes on an input
+void BM_LatencyRecord(benchmark::State& state) {
+    LatencyHistogram histogram;
+    auto latencies = makeLatencies();
+    size_t i = 0;
+    for (auto _ : state) {
+        histogram.record(latencies[i++ & 1023]);
+    }
+    benchmark::DoNotOptimize(histogram.percentile(50.0));
+}
+
+void BM_LatencyStats(benchmark::State& state) {
+    LatencyHistogram histogram;
+    for (int64_t latency : makeLatencies()) {
+        histogram.record(latency);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(histogram.stats());
+    }
+}
+
+}
+
+BENCHMARK(BM_LatencyRecord);
+BENCHMARK(BM_LatencyStats);
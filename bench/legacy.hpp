@@ -0,0 +1,118 @@
+#pragma once
+
+// Implementations as they were before the hot paths got reworked. Only used as baseline in the benchmarks.
+
+#include "sumd_parser.hpp"
+#include "crc.h"
+
+#include <array>
+#include <cstdint>
+
+namespace legacy {
+
+/// crc16() from crc.cpp: one table lookup per byte
+inline unsigned short crc16(const unsigned char *buf, unsigned int len) {
+	unsigned int i;
+	unsigned short cksum = 0;
+	for (i = 0; i < len; i++) {
+		cksum = crc16_tables[0][(((cksum >> 8) ^ *buf++) & 0xFF)] ^ (cksum << 8);
+	}
+	return cksum;
+}
+
+/// RingBuffer before it became a SPSC ring
+template <size_t SIZE_>
+class RingBuffer
+{
+public:
+    std::array<unsigned char, SIZE_> buffer;
+    int writePos = 0;
+    int readPos = 0;
+
+    unsigned char operator[](int pos)
+    {
+        if(pos < available())
+        {
+            return buffer[(readPos + pos) % SIZE_];
+        } else
+        {
+            return -1;
+        }
+    }
+
+    void pop(int count = 1)
+    {
+        if(count > available())
+        {
+            readPos = writePos;
+        } else
+        {
+            readPos = (readPos + count) % SIZE_;
+        }
+    }
+
+    void push(char c)
+    {
+        buffer[writePos] = c;
+        writePos = (writePos + 1) % SIZE_;
+    }
+
+    int available() { return (SIZE_ + writePos - readPos) % SIZE_; }
+};
+
+/// Receiver::analyzePacket before the incremental decoder: rescans the ring and recomputes the crc per candidate header
+template <size_t SIZE_>
+class SumdScanner
+{
+public:
+    RingBuffer<SIZE_> buffer_;
+    SumD_Packet packet{};
+
+    uint16_t sumd_crc16(int len) {
+        unsigned int i;
+        unsigned short cksum = 0;
+        for (i = 0; i < (unsigned)len; i++) {
+            cksum = crc16_tables[0][(((cksum >> 8) ^ buffer_[i]) & 0xFF)] ^ (cksum << 8);
+        }
+        return cksum;
+    }
+
+    int analyzePacket()
+    {
+        int retCount = 0;
+        while(buffer_.available() >= 3 + 24 + 2)
+        {
+            if(buffer_[0] != MAN_ID) {
+                buffer_.pop(1);
+                continue;
+            }
+            uint32_t recvNumChannels = buffer_[2];
+            if(recvNumChannels > MAX_CHAN_COUNT)
+            {
+                buffer_.pop(1);
+                continue;
+            }
+            int payloadSize = 3 + 2 * recvNumChannels;
+            uint16_t crc = sumd_crc16(payloadSize + 2);
+            if(crc != 0)
+            {
+                buffer_.pop(1);
+                continue;
+            }
+            uint8_t *ptr = (uint8_t *)&packet;
+            ptr[0] = buffer_[0];
+            ptr[1] = buffer_[1];
+            ptr[2] = buffer_[2];
+            for(int i = 3; i < payloadSize + 2; i += 2)
+            {
+                ptr[i] = buffer_[i];
+                ptr[i + 1] = buffer_[i+1];
+            }
+            buffer_.pop(payloadSize + 2);
+            retCount++;
+        }
+        return retCount;
+    }
+};
+
+} // namespace legacy
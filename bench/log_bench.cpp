@@ -0,0 +1,77 @@
+#include "log.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+/// the global logger, writing to /dev/null for the whole run
+Logger& benchLogger() {
+    static FILE* devnull = fopen("/dev/null", "w");
+    static bool started = (Logger::global().start(devnull, std::chrono::milliseconds(1000)), true);
+    (void)started;
+    return Logger::global();
+}
+
+// what a LOG statement costs while its level is off
+void BM_LogDisabled(benchmark::State& state) {
+    Logger::setLevel(LogSubsystem::vesc, LogLevel::info);
+    float voltage = 12.5f;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(voltage);
+        LOG_TRACE(vesc, "status packet rpm %d voltage %f", 1200, voltage);
+    }
+}
+
+// what the calling thread pays for an enabled LOG statement, formatting happens elsewhere
+void BM_LogEnabled(benchmark::State& state) {
+    Logger& logger = benchLogger();
+    Logger::setLevel(LogSubsystem::vesc, LogLevel::trace);
+    float voltage = 12.5f;
+    uint64_t droppedBefore = logger.stats().dropped;
+    int64_t n = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(voltage);
+        LOG_TRACE(vesc, "status packet rpm %d voltage %f", 1200, voltage);
+        // drain before the ring fills up, otherwise this measures the drop path
+        if (++n % 256 == 0) {
+            state.PauseTiming();
+            logger.flush();
+            state.ResumeTiming();
+        }
+    }
+    Logger::setLevel(LogSubsystem::vesc, LogLevel::info);
+    state.counters["dropped"] = (double)(logger.stats().dropped - droppedBefore);
+}
+
+void BM_LogString(benchmark::State& state) {
+    Logger& logger = benchLogger();
+    Logger::setLevel(LogSubsystem::recorder, LogLevel::info);
+    const char* dir = "/var/log/drivehub";
+    int64_t n = 0;
+    for (auto _ : state) {
+        LOG_INFO(recorder, "could not create '%s', recording is off", dir);
+        if (++n % 256 == 0) {
+            state.PauseTiming();
+            logger.flush();
+            state.ResumeTiming();
+        }
+    }
+}
+
+// formatting on the writer thread, for comparison with the cost on the calling thread
+void BM_LogFormat(benchmark::State& state) {
+    char line[LOG_MAX_LINE];
+    float voltage = 12.5f;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(voltage);
+        snprintf(line, sizeof(line), "status packet rpm %d voltage %f", 1200, voltage);
+        benchmark::DoNotOptimize(line);
+    }
+}
+
+}
+
+BENCHMARK(BM_LogDisabled);
+BENCHMARK(BM_LogEnabled);
+BENCHMARK(BM_LogString);
+BENCHMARK(BM_LogFormat);
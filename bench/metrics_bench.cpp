@@ -0,0 +1,29 @@
+#include "metrics.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+// what a hot path pays per counted event
+void BM_CounterAdd(benchmark::State& state) {
+    static Counter counter;
+    for (auto _ : state) {
+        counter.add();
+    }
+    benchmark::DoNotOptimize(counter.value());
+}
+
+void BM_MetricsRender(benchmark::State& state) {
+    Metrics metrics;
+    for (int i = 0; i < 40; i++) {
+        metrics.counter("drivehub_bench_total", "benchmark counter", "id=\"" + std::to_string(i) + "\"").add(i);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(metrics.render());
+    }
+}
+
+}
+
+BENCHMARK(BM_CounterAdd)->ThreadRange(1, 4);
+BENCHMARK(BM_MetricsRender);
@@ -0,0 +1,272 @@
+#include "status_msgs.hpp"
+#include "telemetry.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <climits>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// counts the heap allocations of the calling thread, for the whole bench binary
+static thread_local uint64_t allocations = 0;
+
+// GCC inlines these replacements into their callers and then sees free() on memory from operator new
+// (-Wmismatched-new-delete), although both sides are the malloc/free pair defined here
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+/// takes messages by value like SwiftRobotClient::publish and touches them like its encoder would
+struct ByValueClient {
+    template<typename T>
+    void publish(uint16_t channel, T msg) {
+        benchmark::DoNotOptimize(channel);
+        benchmark::DoNotOptimize(msg.data.data());
+    }
+};
+
+VescData vescData() {
+    VescData data;
+    data.mosfet_temp = 41.2;
+    data.motor_temp = 53.8;
+    data.rpm = 12345;
+    data.voltage = 11.8;
+    data.ticks = 987654;
+    data.ticksAbs = 1987654;
+    return data;
+}
+
+ReceiverPacket receiverPacket() {
+    ReceiverPacket packet;
+    packet.throttle = 0.42;
+    packet.steering = 0.61;
+    packet.gearSelector = drive;
+    return packet;
+}
+
+/// the publish paths must not allocate once their message exists
+void reportAllocations(benchmark::State& state, uint64_t before) {
+    uint64_t n = allocations - before;
+    state.counters["allocs"] = benchmark::Counter((double)n, benchmark::Counter::kAvgIterations);
+    if (n > 0) {
+        state.SkipWithError("the publish path allocated");
+    }
+}
+
+// SR_STATUS for every VESC answer: fill the kept message and publish it
+void BM_VescStatusPublish(benchmark::State& state) {
+    VescData data = vescData();
+    ByValueClient client;
+    base_msg::UInt32Array msg;
+    msg.data.reserve(VESC_STATUS_MSG_SIZE);
+    uint64_t before = allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(data);
+        vescStatusMsg(data, msg);
+        publishInPlace(client, 0, msg);
+    }
+    reportAllocations(state, before);
+}
+
+// SR_RECEIVER for every SUMD frame
+void BM_ReceiverPacketPublish(benchmark::State& state) {
+    ReceiverPacket packet = receiverPacket();
+    ByValueClient client;
+    base_msg::UInt16Array msg;
+    msg.data.reserve(RECEIVER_MSG_SIZE);
+    uint64_t before = allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(packet);
+        receiverPacketMsg(packet, msg);
+        publishInPlace(client, 0, msg);
+    }
+    reportAllocations(state, before);
+}
+
+// what every publish cost before: a fresh message, copied into the by value parameter
+void BM_ReceiverPacketPublishCopy(benchmark::State& state) {
+    ReceiverPacket packet = receiverPacket();
+    ByValueClient client;
+    uint64_t before = allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(packet);
+        base_msg::UInt16Array msg;
+        receiverPacketMsg(packet, msg);
+        client.publish(0, msg);
+    }
+    state.counters["allocs"] = benchmark::Counter((double)(allocations - before), benchmark::Counter::kAvgIterations);
+}
+
+/// true if decoded has the value of sample after the encoder scaled it (throttle * 65000, temperatures * 10, ...)
+bool scaledEqual(float sample, float decoded, float scale) {
+    return (int32_t)(sample * scale) == (int32_t)lroundf(decoded * scale);
+}
+
+/// @return error or nullptr. Only the first sample of a frame keeps its ns, the others are us
+const char* compareTelemetrySample(const TelemetrySample& e, const TelemetrySample& d, bool first) {
+    int64_t timestampNs = first ? e.timestampNs : e.timestampNs / 1000 * 1000;
+    if (d.kind != e.kind || d.timestampNs != timestampNs) {
+        return "telemetry sample kind or time changed";
+    }
+    if (e.kind == TelemetryKind::receiver) {
+        if (!scaledEqual(e.receiver.throttle, d.receiver.throttle, 65000) || !scaledEqual(e.receiver.steering, d.receiver.steering, 65000) ||
+            d.receiver.gearSelector != e.receiver.gearSelector || d.receiver.lateral_control != e.receiver.lateral_control ||
+            d.receiver.autonomous != e.receiver.autonomous) {
+            return "telemetry receiver sample changed";
+        }
+    } else if (!scaledEqual(e.vesc.mosfet_temp, d.vesc.mosfet_temp, 10) || !scaledEqual(e.vesc.motor_temp, d.vesc.motor_temp, 10) ||
+               d.vesc.rpm != e.vesc.rpm || !scaledEqual(e.vesc.voltage, d.vesc.voltage, 10) || d.vesc.ticks != e.vesc.ticks ||
+               d.vesc.ticksAbs != e.vesc.ticksAbs) {
+        return "telemetry vesc sample changed";
+    }
+    return nullptr;
+}
+
+/**
+ * encodes samples which need the widest varints (full range int32 deltas, a negative time delta) and decodes them
+ * again, checking every sample against TELEMETRY_MAX_SAMPLE_SIZE on the way
+ * @return error or nullptr
+ **/
+const char* telemetryRoundTrip() {
+    std::vector<TelemetrySample> samples(5);
+    samples[0].kind = TelemetryKind::vesc;
+    samples[0].timestampNs = 1000000000123;
+    samples[0].vesc.mosfet_temp = -2e8f; // -2e9 after scaling
+    samples[0].vesc.motor_temp = 53.5f;
+    samples[0].vesc.rpm = INT32_MIN;
+    samples[0].vesc.voltage = 12.5f;
+    samples[0].vesc.ticks = INT32_MAX;
+    samples[0].vesc.ticksAbs = 0;
+
+    // stamped before the previous sample
+    samples[1].kind = TelemetryKind::receiver;
+    samples[1].timestampNs = samples[0].timestampNs - 1500777;
+    samples[1].receiver.throttle = 1.0f;
+    samples[1].receiver.steering = 0.0f;
+    samples[1].receiver.gearSelector = reverse;
+    samples[1].receiver.lateral_control = true;
+    samples[1].receiver.autonomous = true;
+
+    // every field jumps across the whole int32 range
+    samples[2].kind = TelemetryKind::vesc;
+    samples[2].timestampNs = samples[1].timestampNs + 2000000;
+    samples[2].vesc.mosfet_temp = 2e8f;
+    samples[2].vesc.motor_temp = -2e8f;
+    samples[2].vesc.rpm = INT32_MAX;
+    samples[2].vesc.voltage = -2e8f;
+    samples[2].vesc.ticks = INT32_MIN;
+    samples[2].vesc.ticksAbs = INT32_MAX;
+
+    samples[3].kind = TelemetryKind::receiver;
+    samples[3].timestampNs = samples[2].timestampNs + 3600000000000; // an hour later
+    samples[3].receiver.throttle = 0.5f;
+    samples[3].receiver.steering = 0.25f;
+    samples[3].receiver.gearSelector = drive;
+
+    samples[4] = samples[2];
+    samples[4].timestampNs = samples[3].timestampNs + 999;
+    samples[4].vesc.rpm = INT32_MIN;
+
+    TelemetryEncoder encoder(samples.size());
+    std::vector<uint8_t> frame;
+    for (const TelemetrySample& sample : samples) {
+        size_t before = frame.empty() ? TELEMETRY_HEADER_SIZE : frame.size();
+        encoder.add(sample, frame);
+        if (frame.size() - before > TELEMETRY_MAX_SAMPLE_SIZE) {
+            return "telemetry sample larger than TELEMETRY_MAX_SAMPLE_SIZE";
+        }
+    }
+    if (frame.size() > encoder.capacity()) {
+        return "telemetry frame larger than its capacity";
+    }
+    std::vector<TelemetrySample> decoded;
+    if (!decodeTelemetryFrame(ByteSpan(frame.data(), frame.size()), decoded) || decoded.size() != samples.size()) {
+        return "telemetry frame did not decode";
+    }
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (const char* error = compareTelemetrySample(samples[i], decoded[i], i == 0)) {
+            return error;
+        }
+    }
+    return nullptr;
+}
+
+// SR_TELEMETRY: a 500 Hz receiver stream with a VESC answer every fifth sample, per sample
+void BM_TelemetryFrame(benchmark::State& state) {
+    TelemetryEncoder encoder(256);
+    std::vector<uint8_t> frame;
+    frame.reserve(encoder.capacity());
+    TelemetrySample receiver;
+    receiver.kind = TelemetryKind::receiver;
+    receiver.receiver = receiverPacket();
+    TelemetrySample vesc;
+    vesc.kind = TelemetryKind::vesc;
+    vesc.vesc = vescData();
+    int64_t now = 0;
+    size_t bytes = 0;
+    int64_t n = 0;
+    uint64_t before = allocations;
+    for (auto _ : state) {
+        now += 2000000;
+        TelemetrySample& sample = n % 5 == 0 ? vesc : receiver;
+        sample.timestampNs = now;
+        receiver.receiver.throttle = 0.4f + (n % 100) * 0.001f;
+        vesc.vesc.ticks += 3;
+        encoder.add(sample, frame);
+        if (encoder.full()) {
+            bytes += frame.size();
+            frame.clear();
+        }
+        n++;
+    }
+    bytes += frame.size();
+    reportAllocations(state, before);
+    state.counters["bytes_per_sample"] = (double)bytes / (double)n;
+
+    // the last frame ends with the newest sample of the loop, which is still in receiver / vesc
+    std::vector<TelemetrySample> decoded;
+    const char* error = nullptr;
+    if (!decodeTelemetryFrame(ByteSpan(frame.data(), frame.size()), decoded) || decoded.size() != encoder.samples()) {
+        error = "telemetry frame of the benchmark did not decode";
+    } else if (!decoded.empty()) {
+        error = compareTelemetrySample((n - 1) % 5 == 0 ? vesc : receiver, decoded.back(), decoded.size() == 1);
+    }
+    if (!error) {
+        error = telemetryRoundTrip();
+    }
+    if (error) {
+        state.SkipWithError(error);
+    }
+}
+
+}
+
+BENCHMARK(BM_VescStatusPublish);
+BENCHMARK(BM_ReceiverPacketPublish);
+BENCHMARK(BM_ReceiverPacketPublishCopy);
+BENCHMARK(BM_TelemetryFrame);
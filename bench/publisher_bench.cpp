@@ -0,0 +1,118 @@
+#include "publisher.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+struct Sample {
+    float values[6];
+    int64_t timestampNs;
+};
+
+// what the serial thread pays to hand a value over, with the publisher thread draining
+void BM_PublisherPush(benchmark::State& state) {
+    DropPolicy policy = state.range(0) ? DropPolicy::latestWins : DropPolicy::dropOldest;
+    std::atomic<uint64_t> published{0};
+    Publisher publisher;
+    auto& topic = publisher.addTopic<Sample>("bench", 32, policy, [&](const Sample& sample) {
+        benchmark::DoNotOptimize(sample);
+        published.fetch_add(1, std::memory_order_relaxed);
+    });
+    publisher.start();
+    Sample sample{};
+    for (auto _ : state) {
+        sample.timestampNs++;
+        topic.push(sample);
+    }
+    publisher.stop();
+    state.counters["published"] = benchmark::Counter((double)published.load(), benchmark::Counter::kAvgIterations);
+}
+
+// push with the publisher thread asleep in between, like a 100 Hz SUMD stream: includes the wake up
+void BM_PublisherPushWake(benchmark::State& state) {
+    std::atomic<uint64_t> published{0};
+    Publisher publisher;
+    auto& topic = publisher.addTopic<Sample>("bench", 32, DropPolicy::dropOldest, [&](const Sample&) {
+        published.fetch_add(1, std::memory_order_release);
+    });
+    publisher.start();
+    Sample sample{};
+    uint64_t n = 0;
+    for (auto _ : state) {
+        topic.push(sample);
+        n++;
+        state.PauseTiming();
+        while (published.load(std::memory_order_acquire) < n) {
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        state.ResumeTiming();
+    }
+    publisher.stop();
+}
+
+void BM_DropQueuePushPop(benchmark::State& state) {
+    DropQueue<Sample> queue(32);
+    Sample sample{};
+    for (auto _ : state) {
+        queue.push(sample);
+        queue.pop(sample);
+        benchmark::DoNotOptimize(sample);
+    }
+}
+
+// producer pushing into a full queue while consumers pop. More consumers than cores, so some get preempted between
+// taking a value and releasing its cell. A push may still drop at most the oldest and the new value, and every value
+// has to be either popped, dropped or still queued
+void BM_DropQueueFullContended(benchmark::State& state) {
+    DropQueue<uint64_t> queue(64);
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> popped{0};
+    std::atomic<bool> reordered{false};
+    std::vector<std::thread> consumers;
+    for (unsigned i = 0; i < 2 * std::max(1u, std::thread::hardware_concurrency()); i++) {
+        consumers.emplace_back([&]() {
+            uint64_t value, last = 0, n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (queue.pop(value)) {
+                    // values are pushed in order, so every consumer sees them ascending
+                    if (value <= last) {
+                        reordered.store(true, std::memory_order_relaxed);
+                    }
+                    last = value;
+                    n++;
+                }
+            }
+            popped.fetch_add(n);
+        });
+    }
+    uint64_t next = 1, dropped = 0;
+    size_t worst = 0;
+    for (auto _ : state) {
+        size_t n = queue.pushDropOldest(next++);
+        dropped += n;
+        worst = std::max(worst, n);
+    }
+    stop.store(true);
+    for (std::thread& consumer : consumers) {
+        consumer.join();
+    }
+    uint64_t value, queued = 0;
+    while (queue.pop(value)) {
+        queued++;
+    }
+    if (worst > 2) {
+        state.SkipWithError("a push dropped more than the oldest and the new value");
+    } else if (popped.load() + dropped + queued != next - 1) {
+        state.SkipWithError("values got lost without being counted as dropped");
+    } else if (reordered.load()) {
+        state.SkipWithError("a consumer saw values out of order");
+    }
+    state.counters["dropped"] = benchmark::Counter((double)dropped, benchmark::Counter::kAvgIterations);
+}
+
+}
+
+BENCHMARK(BM_PublisherPush)->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK(BM_PublisherPushWake)->UseRealTime();
+BENCHMARK(BM_DropQueuePushPop);
+BENCHMARK(BM_DropQueueFullContended)->UseRealTime();
@@ -0,0 +1,47 @@
+#include "recorder.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace {
+
+// cost the rx path pays per serial read: timestamp + copy into the thread ring
+void BM_RecordSerialRx(benchmark::State& state) {
+    char dir[] = "/tmp/drivehub_bench_XXXXXX";
+    if (mkdtemp(dir) == nullptr) {
+        state.SkipWithError("no temp dir");
+        return;
+    }
+    {
+        Recorder recorder(dir, 4 * 1024 * 1024, 2);
+        uint8_t source = recorder.sourceId("bench");
+        uint8_t chunk[64];
+        for (size_t i = 0; i < sizeof(chunk); i++) {
+            chunk[i] = (uint8_t)i;
+        }
+        ByteSpan payload(chunk, (size_t)state.range(0));
+        size_t count = 0;
+        for (auto _ : state) {
+            recorder.record(RecordType::serialRx, source, payload);
+            // drain before the ring is full, so only the real record path is measured
+            if (++count % 256 == 0) {
+                state.PauseTiming();
+                recorder.flush();
+                state.ResumeTiming();
+            }
+        }
+        recorder.stop();
+        state.counters["dropped"] = (double)recorder.stats().dropped;
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+    // bounded to 2 chunks, clean up
+    std::string cmd = std::string("rm -rf ") + dir;
+    if (system(cmd.c_str()) != 0) {
+        state.SkipWithError("cleanup failed");
+    }
+}
+BENCHMARK(BM_RecordSerialRx)->Arg(1)->Arg(25)->Arg(64);
+
+}
@@ -0,0 +1,99 @@
+#include "ringbuffer.hpp"
+#include "legacy.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> makeChunk(size_t len) {
+    std::vector<uint8_t> chunk(len);
+    for (size_t i = 0; i < len; i++) {
+        chunk[i] = (uint8_t)(i * 31 + 7);
+    }
+    return chunk;
+}
+
+// one serial read: push a chunk, walk it byte by byte like the parsers do and pop it again
+template <size_t SIZE_>
+void BM_LegacyIngestScan(benchmark::State& state) {
+    legacy::RingBuffer<SIZE_> ring;
+    auto chunk = makeChunk(state.range(0));
+    for (auto _ : state) {
+        for (size_t i = 0; i < chunk.size(); i++) {
+            ring.push(chunk[i]);
+        }
+        unsigned sum = 0;
+        int n = ring.available();
+        for (int i = 0; i < n; i++) {
+            sum += ring[i];
+        }
+        ring.pop(n);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * chunk.size());
+}
+
+template <size_t SIZE_>
+void BM_RingIngestScan(benchmark::State& state) {
+    RingBuffer<SIZE_> ring;
+    auto chunk = makeChunk(state.range(0));
+    for (auto _ : state) {
+        ring.write(ByteSpan(chunk.data(), chunk.size()));
+        unsigned sum = 0;
+        auto spans = ring.peekContiguous();
+        for (uint8_t c : spans.first) sum += c;
+        for (uint8_t c : spans.second) sum += c;
+        ring.pop(spans.size());
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * chunk.size());
+}
+
+// push a chunk and copy it out again
+template <size_t SIZE_>
+void BM_LegacyPushPop(benchmark::State& state) {
+    legacy::RingBuffer<SIZE_> ring;
+    auto chunk = makeChunk(state.range(0));
+    std::vector<uint8_t> out(chunk.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < chunk.size(); i++) {
+            ring.push(chunk[i]);
+        }
+        int n = ring.available();
+        for (int i = 0; i < n; i++) {
+            out[i] = ring[0];
+            ring.pop(1);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * chunk.size());
+}
+
+template <size_t SIZE_>
+void BM_RingWriteRead(benchmark::State& state) {
+    RingBuffer<SIZE_> ring;
+    auto chunk = makeChunk(state.range(0));
+    std::vector<uint8_t> out(chunk.size());
+    for (auto _ : state) {
+        ring.write(ByteSpan(chunk.data(), chunk.size()));
+        ring.read(MutableByteSpan(out.data(), out.size()));
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * chunk.size());
+}
+
+} // namespace
+
+// the legacy ring holds at most SIZE_-1 bytes, chunks are kept below that.
+// 259 bytes (VESC_PACKET_MAXSIZE) is not a power of two, the SPSC ring uses the next one (VESC_BUFFER_SIZE)
+BENCHMARK_TEMPLATE(BM_LegacyIngestScan, 64)->Arg(32)->Arg(63);
+BENCHMARK_TEMPLATE(BM_RingIngestScan, 64)->Arg(32)->Arg(63);
+BENCHMARK_TEMPLATE(BM_LegacyIngestScan, 259)->Arg(64)->Arg(258);
+BENCHMARK_TEMPLATE(BM_RingIngestScan, 512)->Arg(64)->Arg(258);
+
+BENCHMARK_TEMPLATE(BM_LegacyPushPop, 64)->Arg(32)->Arg(63);
+BENCHMARK_TEMPLATE(BM_RingWriteRead, 64)->Arg(32)->Arg(63);
+BENCHMARK_TEMPLATE(BM_LegacyPushPop, 259)->Arg(64)->Arg(258);
+BENCHMARK_TEMPLATE(BM_RingWriteRead, 512)->Arg(64)->Arg(258);
@@ -0,0 +1,122 @@
+#include "sumd_parser.hpp"
+#include "receiver.hpp"
+#include "crc.h"
+#include "legacy.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+void appendFrame(std::vector<uint8_t>& out, int numChannels) {
+    size_t start = out.size();
+    out.push_back(MAN_ID);
+    out.push_back(STATE_NORMAL);
+    out.push_back((uint8_t)numChannels);
+    for (int i = 0; i < numChannels; i++) {
+        uint16_t value = 12000 + i * 100;
+        out.push_back(value >> 8);
+        out.push_back(value & 0xFF);
+    }
+    uint16_t crc = crc16(ByteSpan(out.data() + start, out.size() - start));
+    out.push_back(crc >> 8);
+    out.push_back(crc & 0xFF);
+}
+
+/**
+ * stream of 8 channel frames. noisePercent of the frames get a flipped byte and are followed by a burst
+ * of random garbage that is biased towards header bytes
+ */
+std::vector<uint8_t> makeStream(int frames, int noisePercent) {
+    std::mt19937 rng(42);
+    std::vector<uint8_t> out;
+    for (int f = 0; f < frames; f++) {
+        size_t start = out.size();
+        appendFrame(out, 8);
+        if ((int)(rng() % 100) < noisePercent) {
+            out[start + 3 + rng() % 16] ^= 0x5A;
+            int garbage = 8 + rng() % 32;
+            for (int i = 0; i < garbage; i++) {
+                out.push_back((rng() % 4 == 0) ? MAN_ID : (uint8_t)rng());
+            }
+        }
+    }
+    return out;
+}
+
+// the serial layer delivers the stream in chunks; the legacy 64 byte ring can take at most 63 bytes at once
+constexpr size_t CHUNK = 32;
+
+void BM_SumdParser(benchmark::State& state) {
+    auto stream = makeStream(1000, state.range(0));
+    SumdParser parser;
+    int frames = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < stream.size(); i += CHUNK) {
+            size_t len = std::min(CHUNK, stream.size() - i);
+            frames += parser.feed(ByteSpan(stream.data() + i, len));
+        }
+    }
+    benchmark::DoNotOptimize(frames);
+    state.SetBytesProcessed(state.iterations() * stream.size());
+    state.counters["frames"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+}
+
+void BM_LegacySumdScan(benchmark::State& state) {
+    auto stream = makeStream(1000, state.range(0));
+    legacy::SumdScanner<64> scanner;
+    int frames = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < stream.size(); i += CHUNK) {
+            size_t len = std::min(CHUNK, stream.size() - i);
+            for (size_t j = 0; j < len; j++) {
+                scanner.buffer_.push(stream[i + j]);
+            }
+            frames += scanner.analyzePacket();
+        }
+    }
+    benchmark::DoNotOptimize(frames);
+    state.SetBytesProcessed(state.iterations() * stream.size());
+    state.counters["frames"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+}
+
+// the whole receive path: ring, parser, channel mapping and packet callback
+void BM_ReceiverFeed(benchmark::State& state) {
+    auto stream = makeStream(1000, state.range(0));
+    Receiver receiver;
+    int packets = 0;
+    receiver.setPacketReceivedCallback([&](ReceiverPacket packet) { packets++; });
+    for (auto _ : state) {
+        for (size_t i = 0; i < stream.size(); i += CHUNK) {
+            size_t len = std::min(CHUNK, stream.size() - i);
+            receiver.feed(ByteSpan(stream.data() + i, len));
+        }
+    }
+    benchmark::DoNotOptimize(packets);
+    state.SetBytesProcessed(state.iterations() * stream.size());
+    state.counters["packets"] = benchmark::Counter(packets, benchmark::Counter::kIsRate);
+}
+
+void BM_SumdToReceiverPacket(benchmark::State& state) {
+    std::vector<uint8_t> frame;
+    appendFrame(frame, 8);
+    SumdParser parser;
+    parser.feed(ByteSpan(frame.data(), frame.size()));
+    SumD_Packet sumd = parser.packet();
+    ReceiverPacket packet;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sumd);
+        Receiver::SumD_to_ReceiverPacket(sumd, &packet);
+        benchmark::DoNotOptimize(packet);
+    }
+}
+
+} // namespace
+
+// argument is the percentage of corrupted frames
+BENCHMARK(BM_SumdParser)->Arg(0)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_LegacySumdScan)->Arg(0)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_ReceiverFeed)->Arg(0)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_SumdToReceiverPacket);
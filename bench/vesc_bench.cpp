@@ -0,0 +1,99 @@
+#include "vesc.hpp"
+#include "vesc_commands.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+void appendU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(value >> 8);
+    out.push_back(value & 0xFF);
+}
+
+void appendU32(std::vector<uint8_t>& out, uint32_t value) {
+    appendU16(out, value >> 16);
+    appendU16(out, value & 0xFFFF);
+}
+
+/// answer to requestState(), framed
+std::vector<uint8_t> makeStatusFrame() {
+    std::vector<uint8_t> payload;
+    payload.push_back(COMM_GET_VALUES_SELECTIVE);
+    appendU32(payload, VESC_VALUES_MASK);
+    appendU16(payload, 412); // fet temp
+    appendU16(payload, 538); // motor temp
+    appendU32(payload, 12345); // rpm
+    appendU16(payload, 118); // input voltage
+    appendU32(payload, 987654); // tachometer
+    appendU32(payload, 1987654); // tachometer abs
+    std::vector<uint8_t> frame(payload.size() + VESC_FRAME_OVERHEAD_MAX);
+    frame.resize(vescEncodeFrame(ByteSpan(payload.data(), payload.size()), MutableByteSpan(frame.data(), frame.size())));
+    return frame;
+}
+
+// status frames delivered in reads of range(0) bytes: decoder, crc and value decoding
+void BM_VescFeed(benchmark::State& state) {
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> frame = makeStatusFrame();
+    for (int i = 0; i < 64; i++) {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    const size_t chunk = state.range(0);
+    Vesc vesc([](ByteSpan payload) {});
+    int values = 0;
+    vesc.setStatusReceivedCallback([&](VescData data) { values++; });
+    for (auto _ : state) {
+        for (size_t i = 0; i < stream.size(); i += chunk) {
+            size_t len = std::min(chunk, stream.size() - i);
+            vesc.feed(ByteSpan(stream.data() + i, len));
+        }
+    }
+    benchmark::DoNotOptimize(values);
+    state.SetBytesProcessed(state.iterations() * stream.size());
+    state.counters["frames"] = benchmark::Counter(values, benchmark::Counter::kIsRate);
+}
+
+// a stray long start byte announcing a 496 byte payload in front of a few status frames. The frames have to be
+// decoded right away instead of after the 499 bytes the stray header claims
+void BM_VescResync(benchmark::State& state) {
+    const uint8_t stray[] = {VESC_FRAME_START_LONG, 0x01, 0xF0};
+    std::vector<uint8_t> frame = makeStatusFrame();
+    std::vector<uint8_t> stream(stray, stray + sizeof(stray));
+    for (int i = 0; i < 3; i++) {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    Vesc vesc([](ByteSpan payload) {});
+    int values = 0;
+    vesc.setStatusReceivedCallback([&](VescData data) { values++; });
+    for (auto _ : state) {
+        values = 0;
+        vesc.feed(ByteSpan(stream.data(), stream.size()));
+        if (values != 3) {
+            state.SkipWithError("frames behind a stray start byte were held back");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * stream.size());
+}
+
+// what a tick costs on the command side, up to the tx queue
+void BM_VescSetpoints(benchmark::State& state) {
+    size_t bytes = 0;
+    Vesc vesc([&](ByteSpan payload) { bytes += payload.size(); });
+    float value = 0.0;
+    for (auto _ : state) {
+        value = value > 1.0f ? 0.0f : value + 0.001f;
+        vesc.setServoPos(value);
+        vesc.setDutyCycle(value);
+    }
+    benchmark::DoNotOptimize(bytes);
+}
+
+}
+
+// bytes per serial read
+BENCHMARK(BM_VescFeed)->Arg(1)->Arg(16)->Arg(64)->Arg(1024);
+BENCHMARK(BM_VescResync);
+BENCHMARK(BM_VescSetpoints);
@@ -0,0 +1,136 @@
+#include "vesc_tx.hpp"
+#include "clock.hpp"
+#include "vesc_commands.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// the VESC end of a pty, the queue writes to its slave
+class PtyPeer {
+public:
+    PtyPeer() {
+        fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd_ >= 0 && (grantpt(fd_) != 0 || unlockpt(fd_) != 0)) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+    ~PtyPeer() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool ok() const { return fd_ >= 0; }
+    std::string slave() const { return ptsname(fd_); }
+
+    /// reads until count frames came in or the timeout passed, returns their payloads in order
+    std::vector<std::vector<uint8_t>> readFrames(size_t count, int timeoutMs) {
+        std::vector<std::vector<uint8_t>> frames;
+        int64_t deadline = monotonicNs() + (int64_t)timeoutMs * 1000000;
+        while (frames.size() < count) {
+            int64_t wait = (deadline - monotonicNs()) / 1000000;
+            pollfd pfd = {fd_, POLLIN, 0};
+            if (wait <= 0 || poll(&pfd, 1, (int)wait) <= 0) {
+                break;
+            }
+            uint8_t buf[256];
+            ssize_t n = read(fd_, buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            decoder_.write(ByteSpan(buf, n));
+            ByteSpan payload;
+            while (decoder_.next(payload)) {
+                frames.emplace_back(payload.begin(), payload.end());
+            }
+        }
+        return frames;
+    }
+
+private:
+    int fd_;
+    VescFrameDecoder decoder_;
+};
+
+// six state requests and a brake command queued at once at 9600 baud. The 30 ms budget (28.8 bytes) holds two
+// of the 10 byte frames. The brake has to leave first, the requests held back by the budget have to follow once
+// it refills: the 41.2 bytes beyond the budget need 43 ms at 960 bytes/s
+void BM_VescTxPriority(benchmark::State& state) {
+    const size_t requests = 6;
+    const auto cycle = std::chrono::milliseconds(30);
+    const int64_t minPacedNs = 40000000;
+    PtyPeer peer;
+    if (!peer.ok()) {
+        state.SkipWithError("no pty");
+        return;
+    }
+    Reactor reactor;
+    Serial ser(reactor, peer.slave(), 9600);
+    VescTxQueue queue(reactor, ser, 9600, cycle);
+    reactor.start();
+
+    const char* error = nullptr;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::this_thread::sleep_for(cycle); // full budget
+        state.ResumeTiming();
+        uint64_t deferredBefore = queue.deferred();
+        int64_t start = monotonicNs();
+        // hold the reactor, so all frames are pending in the same flush
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        boost::asio::post(reactor.context(), [released]() { released.wait(); });
+        uint8_t request[5] = {COMM_GET_VALUES_SELECTIVE, 0, 0, 0, 0};
+        for (size_t i = 0; i < requests; i++) {
+            request[4] = (uint8_t)i;
+            queue.send(ByteSpan(request, sizeof(request)), VescTxClass::telemetry, false);
+        }
+        uint8_t brake[5] = {COMM_SET_CURRENT_BRAKE, 0, 0, 0x27, 0x10};
+        queue.send(ByteSpan(brake, sizeof(brake)), VescTxClass::emergency, true);
+        release.set_value();
+
+        std::vector<std::vector<uint8_t>> frames = peer.readFrames(requests + 1, 1000);
+        int64_t elapsed = monotonicNs() - start;
+        if (frames.size() != requests + 1) {
+            error = "frames held back by the budget were not sent";
+            break;
+        }
+        if (frames[0][0] != COMM_SET_CURRENT_BRAKE) {
+            error = "the emergency frame waited behind queued telemetry";
+            break;
+        }
+        for (size_t i = 1; i < frames.size(); i++) {
+            if (frames[i][0] != COMM_GET_VALUES_SELECTIVE || frames[i].back() != i - 1) {
+                error = "telemetry frames were lost or reordered";
+                break;
+            }
+        }
+        if (error) {
+            break;
+        }
+        if (queue.deferred() - deferredBefore < requests - 1 || elapsed < minPacedNs) {
+            error = "the telemetry frames were not paced by the budget";
+            break;
+        }
+    }
+    reactor.stop();
+    if (error) {
+        state.SkipWithError(error);
+    }
+}
+
+}
+
+BENCHMARK(BM_VescTxPriority)->Iterations(5)->UseRealTime()->Unit(benchmark::kMillisecond);
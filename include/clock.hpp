@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <time.h>
+
+/// CLOCK_MONOTONIC in ns, the time base of all timestamps (recorder, latencies, logs)
+inline int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
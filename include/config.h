@@ -21,11 +21,56 @@ using namespace std::chrono_literals;
 #define SR_DRIVE (uint16_t) 0x01
 #define SR_STATUS (uint16_t) 0x11
 #define SR_RECEIVER (uint16_t) 0x13
+#define SR_TELEMETRY (uint16_t) 0x15
 
 #define TIMEOUT_HARDWARE 50ms
+#define INPUT_MAX_AGE 20ms // inputs older than this are not passed to the FSM anymore
 
-#define INTERVAL_TIMEOUT_CHECK 50 // ms
-#define INTERVAL_VESCSTATUS_PUBLISH 100 // ms
+// core the serial reactor thread is pinned to. -1 disables pinning
+#define REACTOR_CPU -1
+
+// control loop which sends the setpoints to the VESC
+#define CONTROL_LOOP_RATE 200 // Hz
+#define CONTROL_LOOP_PRIORITY 0 // SCHED_FIFO priority, 0 keeps the default scheduler
+#define CONTROL_LOOP_CPU -1 // core the control loop is pinned to, -1 disables pinning
+
+#define VESC_BAUD 115200
+#define VESC_TX_CYCLE 10ms // the VESC port buffers at most the bytes the line sends in this time
+
+// VESC state polling, rates in Hz. Both are capped to what the link carries next to the control commands
+// (about 370 Hz at 115200 baud)
+#define VESC_POLL_IDLE_RATE 10
+#define VESC_POLL_MOVING_RATE 200
+#define VESC_POLL_MOVING_RPM 100 // |rpm| above which the car counts as moving
+#define VESC_POLL_MOVING_HOLD 1000ms // keeps the moving rate for this long after the car stopped
+#define VESC_POLL_TIMEOUT 50ms // a request without answer is given up after this
+#define VESC_POLL_TX_SHARE 0.4 // part of the tx direction the requests may use
+#define VESC_POLL_RX_SHARE 0.9 // part of the rx direction the answers may use
+
+// flight recorder, disk usage is bounded by RECORDER_MAX_CHUNKS * RECORDER_CHUNK_SIZE
+#define RECORDER_DIR "/var/log/drivehub"
+#define RECORDER_CHUNK_SIZE (4 * 1024 * 1024) // bytes
+#define RECORDER_MAX_CHUNKS 16
+#define RECORDER_FLUSH_INTERVAL 20ms
+
+// Prometheus text export. Scrape with e.g. 'socat - UNIX-CONNECT:/run/drivehub-metrics.sock'
+#define METRICS_SOCKET "/run/drivehub-metrics.sock"
+#define METRICS_INTERVAL 1000ms // rate window and rewrite period of the metrics file
+
+// swiftrobot publisher thread. dropOldest queues up to DEPTH values, latestWins only keeps the newest one
+#define PUBLISH_STATUS_DEPTH 4
+#define PUBLISH_STATUS_POLICY DropPolicy::latestWins
+#define PUBLISH_RECEIVER_DEPTH 32
+#define PUBLISH_RECEIVER_POLICY DropPolicy::dropOldest
+// default publish policies, --publish changes single values: topic.max / topic.min (per second) and topic.deadband
+#define PUBLISH_POLICY "receiver.max=50,receiver.min=5,receiver.deadband=0,status.max=20,status.min=1,status.deadband=0"
+// batched telemetry on SR_TELEMETRY, turned on with --telemetry
+#define TELEMETRY_FLUSH_INTERVAL 100ms
+#define TELEMETRY_MAX_SAMPLES 256 // per frame, a full frame is sent right away
+#define TELEMETRY_QUEUE_DEPTH 256
+
+// asynchronous logger, levels are set with --log
+#define LOG_FLUSH_INTERVAL 10ms
 
 #define STEERING_MAX_DELTA 0.3
 #define STEERING_OFFSET 0.1
@@ -2,20 +2,48 @@
 #define CONTEXT_HPP
 
 #include "states/base_state.hpp"
+#include "states/transitions.hpp"
+#include "states/setup.hpp"
+#include "states/manual_waiting.hpp"
+#include "states/manual_control.hpp"
+#include "states/lateral_control.hpp"
+#include "states/autonomous.hpp"
+#include "states/fail_safe.hpp"
 #include "receiver.hpp"
 #include "vesc.hpp"
 #include "timer.hpp"
 #include "ledcontroller.hpp"
+#include "recorder.hpp"
+#include "metrics.hpp"
 
 #include "swiftrobotc/swiftrobotc.h"
 #include "swiftrobotc/msgs.h"
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <variant>
 #include <unistd.h>
 
+/// actuator values requested by the current state. Sent to the VESC once per control loop tick
+struct Setpoint {
+    /// in range [0.0 , 1.0]
+    float steering = FAILSAFE_STEERING;
+    float dutyCycle = FAILSAFE_DUTYCYCLE;
+};
+
 class Context {
+public:
+    /// all states by value, so a transition never allocates. Order has to match StateId
+    using State = std::variant<Setup, Manual_Waiting, Manual_Control, Lateral_Control, Autonomous, Fail_Safe>;
 private:
-    std::unique_ptr<BaseState> state_;
-    std::unique_ptr<BaseState> history_;
+    State state_;
+    /// state before the last transition, if there is one to go back to
+    std::optional<StateId> history_;
+    Setpoint setpoint_;
+    /// transitions into each state
+    std::array<Counter*, (size_t)StateId::count> transitions_;
 public:
     // application properties
     std::shared_ptr<SwiftRobotClient> swiftrobotclient;
@@ -24,42 +52,68 @@ public:
     std::shared_ptr<LEDController> ledcontroller;
 
     // flags
-    bool swiftrobotConnected;
+    /// written by the swiftrobot callback, read by the FSM
+    std::atomic<bool> swiftrobotConnected;
+
+    /// called before every transition, e.g. to compare them in a replay
+    std::function<void(StateId from, StateId to)> transitionObserver;
 public: 
-    Context(BaseState* state, 
+    Context(StateId state, 
             std::shared_ptr<SwiftRobotClient> &swiftrobotclient,
             std::shared_ptr<Vesc> &vesc,
             std::shared_ptr<Receiver> &receiver,
-            std::shared_ptr<LEDController> &ledcontroller): state_(nullptr), history_(nullptr) {
+            std::shared_ptr<LEDController> &ledcontroller) {
         this->swiftrobotclient = swiftrobotclient;
         this->vesc = vesc;
         this->receiver = receiver;
         this->ledcontroller = ledcontroller;
         this->swiftrobotConnected = false;
+        for (size_t i = 0; i < (size_t)StateId::count; i++) {
+            this->transitions_[i] = &Metrics::global().counter("drivehub_fsm_transitions_total", "FSM transitions by target state",
+                                                               std::string("to=\"") + stateName((StateId)i) + "\"");
+        }
 
-        this->transitionTo(state);
+        this->enter(state);
     }
 
     ~Context() {
         
     }
 
-    void transitionTo(BaseState *state) {
-        if (this->state_ != nullptr) {
-            this->state_->exit();
-        }
-        this->history_ = std::move(this->state_);
-        this->state_.reset(state);
-        this->state_->set_context(this);
-        this->state_->entry();
+    StateId stateId() const {
+        return (StateId)this->state_.index();
+    }
+
+    void transitionTo(StateId state) {
+        this->recordTransition(state);
+        std::visit([](auto& s) { s.exit(); }, this->state_);
+        this->history_ = this->stateId();
+        this->enter(state);
     }
 
     void transitionToHistory() {
-        if (this->history_ != nullptr) {
-            this->state_->exit();
-            this->state_ = std::move(this->history_);
-            this->state_->set_context(this);
-            this->state_->entry();
+        if (this->history_) {
+            StateId state = *this->history_;
+            this->recordTransition(state);
+            std::visit([](auto& s) { s.exit(); }, this->state_);
+            this->history_.reset();
+            this->enter(state);
+        }
+    }
+
+    /// looks up the transition for the signal in the current state and takes it if its guard allows
+    void signal(Signal signal) {
+        const TransitionEntry& t = transitionTable[(size_t)this->stateId()][(size_t)signal];
+        if (!t.valid) {
+            return;
+        }
+        if (t.guard == Guard::swiftrobotConnected && !this->swiftrobotConnected) {
+            return;
+        }
+        if (t.toHistory) {
+            this->transitionToHistory();
+        } else {
+            this->transitionTo(t.to);
         }
     }
 
@@ -67,42 +121,97 @@ public:
     // These are used to pass certain information that was externally updated to the states
 
     void updateReceiverPacket(ReceiverPacket packet) {
-        
+        std::visit([&](auto& s) { s.ReceiverPacketUpdated(packet); }, this->state_);
     }
 
     void updateDriveMsg(control_msg::Drive msg) {
+        std::visit([&](auto& s) { s.DriveMsgUpdated(msg); }, this->state_);
+    }
+
+    // setpoints
+    // States only store what they want the actuators to do. The control loop sends it
 
+    void setServoPos(float pos) {
+        this->setpoint_.steering = pos;
+    }
+
+    void setDutyCycle(float duty) {
+        this->setpoint_.dutyCycle = duty;
+    }
+
+    const Setpoint& setpoint() const {
+        return this->setpoint_;
+    }
+
+    /// sends the current setpoint pair to the VESC. In fail safe it goes ahead of everything else on the link
+    void emitSetpoint() {
+        VescTxClass cls = this->stateId() == StateId::failSafe ? VescTxClass::emergency : VescTxClass::setpoint;
+        this->vesc->setServoPos(this->setpoint_.steering, cls);
+        this->vesc->setDutyCycle(this->setpoint_.dutyCycle, cls);
     }
 
     // signals
 
     void manualControl() {
-        this->state_->manualControl();
+        this->signal(Signal::manualControl);
     }
 
     void autonomousControl() {
-        this->state_->autonomousControl();
+        this->signal(Signal::autonomousControl);
     }
 
     void lateralControl() {
-        this->state_->lateralControl();
+        this->signal(Signal::lateralControl);
     }
 
     void receiverTimedOut() {
-        this->state_->receiverTimedOut();
+        this->signal(Signal::receiverTimedOut);
     }
 
     void receiverMotorReset() {
-        this->state_->receiverMotorReset();
+        this->signal(Signal::receiverMotorReset);
     }
 
     void swiftrobotTimedOut() {
-        this->state_->swiftrobotTimedOut();
+        this->signal(Signal::swiftrobotTimedOut);
     }
 
     void receiverConnected() {
-        this->state_->receiverConnected();
+        this->signal(Signal::receiverConnected);
+    }
+
+private:
+    void recordTransition(StateId to) {
+        this->transitions_[(size_t)to]->add();
+        if (this->transitionObserver) {
+            this->transitionObserver(this->stateId(), to);
+        }
+        if (Recorder* recorder = Recorder::active()) {
+            uint8_t transition[2] = {(uint8_t)this->stateId(), (uint8_t)to};
+            recorder->record(RecordType::transition, 0, ByteSpan(transition, 2));
+        }
+    }
+
+    /// constructs the state in place and runs its entry action
+    void enter(StateId state) {
+        switch (state) {
+            case StateId::setup: this->state_.emplace<Setup>(); break;
+            case StateId::manualWaiting: this->state_.emplace<Manual_Waiting>(); break;
+            case StateId::manualControl: this->state_.emplace<Manual_Control>(); break;
+            case StateId::lateralControl: this->state_.emplace<Lateral_Control>(); break;
+            case StateId::autonomous: this->state_.emplace<Autonomous>(); break;
+            case StateId::failSafe: this->state_.emplace<Fail_Safe>(); break;
+            default: return;
+        }
+        std::visit([this](auto& s) {
+            s.set_context(this);
+            s.entry();
+        }, this->state_);
     }
 };
 
+static_assert(std::variant_size_v<Context::State> == (size_t)StateId::count, "every StateId needs a state");
+static_assert(std::is_same_v<std::variant_alternative_t<(size_t)StateId::failSafe, Context::State>, Fail_Safe>,
+              "order of Context::State does not match StateId");
+
 #endif
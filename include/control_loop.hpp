@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+struct ControlLoopStats {
+    uint64_t ticks = 0;
+    /// ticks which ended after the start of the next period. Missed periods are skipped
+    uint64_t overruns = 0;
+    /// wake up delay behind the scheduled tick start
+    int64_t lastJitterNs = 0;
+    int64_t maxJitterNs = 0;
+    int64_t meanJitterNs = 0;
+    /// time spent in the tick function
+    int64_t maxTickNs = 0;
+};
+
+/**
+ * Fixed rate thread which runs the control step. Sleeps with clock_nanosleep on absolute CLOCK_MONOTONIC
+ * deadlines, so the period does not drift with the duration of the tick.
+ * Can optionally run with SCHED_FIFO and be pinned to a core.
+ */
+class ControlLoop {
+public:
+    explicit ControlLoop(std::function<void(void)> tick);
+    ~ControlLoop();
+
+    /**
+     * @param rate - ticks per second
+     * @param priority - SCHED_FIFO priority (1-99). 0 keeps the default scheduler
+     * @param cpu - core the thread is pinned to. Negative value disables pinning
+     **/
+    void start(int rate, int priority = 0, int cpu = -1);
+    void stop();
+
+    ControlLoopStats stats() const;
+
+private:
+    void run(int64_t periodNs);
+
+    std::function<void(void)> tick_;
+    std::thread thread_;
+    std::atomic<bool> active_{false};
+
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<int64_t> lastJitterNs_{0};
+    std::atomic<int64_t> maxJitterNs_{0};
+    std::atomic<int64_t> sumJitterNs_{0};
+    std::atomic<int64_t> maxTickNs_{0};
+};
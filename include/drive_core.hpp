@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "context.hpp"
+#include "latency_histogram.hpp"
+#include "mailbox.hpp"
+
+/**
+ * Control path between the inputs and the VESC: latest-value mailboxes for receiver and drive inputs, the FSM
+ * signals derived from them and the setpoint sent once per tick. Time comes from an injected clock, so the same
+ * code runs live (CLOCK_MONOTONIC) and in the replay (recorded time).
+ */
+class DriveCore {
+public:
+    /// @return current time in ns on the CLOCK_MONOTONIC time base
+    using Clock = std::function<int64_t(void)>;
+
+    DriveCore(Context& context, Clock now);
+
+    /// input callbacks. Lock free, can be called from any one thread per input
+    void receiverInput(const ReceiverPacket& packet);
+    void driveInput(const control_msg::Drive& msg);
+
+    /// passes the latest inputs to the FSM and sends exactly one setpoint pair
+    void tick();
+
+    /// heartbeat timeouts
+    void receiverTimedOut();
+    void swiftrobotTimedOut();
+
+    /// last byte of a SUMD frame read -> COMM_SET_DUTY with that input handed to the VESC
+    const LatencyHistogram& receiverLatency() const { return receiverLatency_; }
+    /// drive message received -> COMM_SET_SERVO_POS with that input handed to the VESC
+    const LatencyHistogram& driveLatency() const { return driveLatency_; }
+
+    /// lock for everything else that touches the context
+    std::mutex& contextMutex() { return m_context_; }
+
+private:
+    template<typename Snapshot>
+    bool takeFresh(const Snapshot& snapshot, uint64_t& seen, int64_t now);
+
+    Mailbox<ReceiverPacket>::Clock::time_point timePoint(int64_t ns) const;
+    int64_t toNs(Mailbox<ReceiverPacket>::Clock::time_point timePoint) const;
+
+    Context& context_;
+    Clock now_;
+    std::mutex m_context_;
+
+    Mailbox<ReceiverPacket> receiverInput_;
+    Mailbox<control_msg::Drive> driveInput_;
+    /// sequence numbers of the inputs already passed to the FSM
+    uint64_t receiverInputSeen_ = 0;
+    uint64_t driveInputSeen_ = 0;
+
+    LatencyHistogram receiverLatency_;
+    LatencyHistogram driveLatency_;
+};
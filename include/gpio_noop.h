@@ -0,0 +1,12 @@
+#pragma once
+
+// stands in for pigpio.h when the drivehub is built without it (WITH_PIGPIO=OFF), e.g. to run it
+// against drivehub_sim on a normal Linux machine. All GPIO calls succeed and do nothing
+
+#define PI_OUTPUT 1
+
+inline int gpioInitialise() { return 0; }
+inline void gpioTerminate() {}
+inline int gpioSetMode(unsigned /*gpio*/, unsigned /*mode*/) { return 0; }
+inline int gpioWrite(unsigned /*gpio*/, unsigned /*level*/) { return 0; }
+inline int gpioPWM(unsigned /*user_gpio*/, unsigned /*dutycycle*/) { return 0; }
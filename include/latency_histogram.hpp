@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// summary of a LatencyHistogram, all values in ns
+struct LatencyStats {
+    uint64_t count = 0;
+    int64_t p50 = 0;
+    int64_t p99 = 0;
+    int64_t p999 = 0;
+    int64_t max = 0;
+    double mean = 0;
+};
+
+/**
+ * HDR style histogram for latencies in ns. Every power of two is split into 64 linear buckets, so a
+ * percentile is off by less than 1.6 % over the whole range from 1 ns to about 18 minutes. Recording is
+ * wait free and never allocates. One thread records, any thread can read.
+ */
+class LatencyHistogram {
+public:
+    /// linear buckets per power of two, as bits
+    static constexpr int SUB_BITS = 6;
+    /// largest value which still gets its own bucket, larger ones count into the last one
+    static constexpr int MAX_BITS = 40;
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) << SUB_BITS;
+
+    LatencyHistogram() { reset(); }
+
+    void record(int64_t ns) {
+        if (ns < 0) {
+            ns = 0;
+        }
+        // single writer, so plain stores instead of locked read-modify-writes
+        std::atomic<uint64_t>& count = counts_[bucket(ns)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total_.store(total_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        if (ns > max_.load(std::memory_order_relaxed)) {
+            max_.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    /// @param p - percentile in range [0.0 , 100.0]
+    /// @return highest value that falls into the same bucket as the value at p, 0 if nothing was recorded
+    int64_t percentile(double p) const;
+
+    LatencyStats stats() const;
+
+    /// not synchronized with record(), counts of a concurrent record may get lost
+    void reset();
+
+    /// prints "<name> n p50 p99 p99.9 max" in us
+    void print(const char* name) const;
+
+    static size_t bucket(int64_t ns) {
+        uint64_t value = (uint64_t)ns;
+        if (value >= (1ULL << MAX_BITS)) {
+            return BUCKETS - 1;
+        }
+        if (value < (2ULL << SUB_BITS)) {
+            return (size_t)value;
+        }
+        int shift = 63 - __builtin_clzll(value) - SUB_BITS;
+        return ((size_t)shift << SUB_BITS) + (size_t)(value >> shift);
+    }
+
+    /// highest value which is counted into bucket index
+    static int64_t upperBound(size_t index) {
+        if (index < (2ULL << SUB_BITS)) {
+            return (int64_t)index;
+        }
+        int shift = (int)(index >> SUB_BITS) - 1;
+        uint64_t sub = index - ((size_t)shift << SUB_BITS);
+        return (int64_t)(((sub + 1) << shift) - 1);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_;
+    std::atomic<uint64_t> total_;
+    std::atomic<int64_t> sum_;
+    std::atomic<int64_t> max_;
+};
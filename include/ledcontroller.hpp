@@ -1,6 +1,10 @@
 #pragma once
 
+#ifdef NO_PIGPIO
+#include "gpio_noop.h"
+#else
 #include "pigpio.h"
+#endif
 #include "timer.hpp"
 
 #define AUTONOMOUS_LED_GPIO 27
@@ -21,13 +25,6 @@
 #define SETUP_COMPLETE_BLINK_INTERVAL 300 // ms
 #define TURNSIGNAL_BLINK_INTERVAL 500 // ms
 
-//#define DEBUGGING
-#ifdef DEBUGGING
-#define DBG_PRINT(x...) printf(x)
-#else
-#define DBG_PRINT(x...) //
-#endif
-
 /**
  * abstracts control of the LEDs into higher level methods.
  * Methods which start with 'signal' play a pre defined sequence. Can be overwritten with a 'turnOff' method of the same LED
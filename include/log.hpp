@@ -0,0 +1,262 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "ringbuffer.hpp"
+
+/// per thread ring for log records
+#define LOG_RING_SIZE (16 * 1024)
+/// encoded arguments of one record. Strings are cut to fit
+#define LOG_MAX_ARGS_SIZE 512
+/// longest formatted line
+#define LOG_MAX_LINE 512
+
+enum class LogLevel : uint8_t {
+    off,
+    error,
+    warn,
+    info,
+    debug,
+    trace
+};
+
+enum class LogSubsystem : uint8_t {
+    core,
+    fsm,
+    receiver,
+    vesc,
+    led,
+    swiftrobot,
+    recorder,
+    metrics,
+    count
+};
+
+/// formats the encoded arguments of a record with the format string of its call site
+using LogFormatter = int (*)(const char* format, const uint8_t* args, char* out, size_t size);
+
+/// one LOG_* statement. Lives in a function local static, its address is the id written to the ring
+struct LogSite {
+    const char* format;
+    LogLevel level;
+    LogSubsystem subsystem;
+    LogFormatter formatter;
+};
+
+namespace logdetail {
+
+/// numbers, enums and pointers are copied as they are. floats are widened like printf does it
+template<typename T, typename = void>
+struct Arg {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                  "only numbers, enums, pointers and strings can be logged");
+    using Stored = std::conditional_t<std::is_floating_point<T>::value, std::common_type<double>,
+                   std::conditional_t<std::is_enum<T>::value, std::underlying_type<T>,
+                   std::conditional_t<std::is_pointer<T>::value, std::common_type<const void*>, std::common_type<T>>>>;
+    using Value = typename Stored::type;
+
+    static size_t size(const T&, size_t) { return sizeof(Value); }
+    static uint8_t* encode(uint8_t* out, const T& value, size_t) {
+        Value v = (Value)value;
+        memcpy(out, &v, sizeof(v));
+        return out + sizeof(v);
+    }
+    static Value decode(const uint8_t*& in) {
+        Value v;
+        memcpy(&v, in, sizeof(v));
+        in += sizeof(v);
+        return v;
+    }
+};
+
+template<>
+struct Arg<double> {
+    static size_t size(double, size_t) { return sizeof(double); }
+    static uint8_t* encode(uint8_t* out, double value, size_t) {
+        memcpy(out, &value, sizeof(value));
+        return out + sizeof(value);
+    }
+    static double decode(const uint8_t*& in) {
+        double v;
+        memcpy(&v, in, sizeof(v));
+        in += sizeof(v);
+        return v;
+    }
+};
+
+/// C strings are copied with a 16 bit length and a terminating zero, so the formatter can point into the record
+struct StringArg {
+    static size_t length(const char* s, size_t limit) {
+        size_t n = s ? strnlen(s, limit) : 0;
+        return n;
+    }
+    static uint8_t* encode(uint8_t* out, const char* s, size_t n) {
+        uint16_t len = (uint16_t)n;
+        memcpy(out, &len, sizeof(len));
+        if (n > 0) {
+            memcpy(out + sizeof(len), s, n);
+        }
+        out[sizeof(len) + n] = 0;
+        return out + sizeof(len) + n + 1;
+    }
+    static const char* decode(const uint8_t*& in) {
+        uint16_t len;
+        memcpy(&len, in, sizeof(len));
+        const char* s = reinterpret_cast<const char*>(in + sizeof(len));
+        in += sizeof(len) + len + 1;
+        return s;
+    }
+};
+
+template<>
+struct Arg<const char*> {
+    static size_t size(const char* s, size_t limit) { return sizeof(uint16_t) + StringArg::length(s, limit) + 1; }
+    static uint8_t* encode(uint8_t* out, const char* s, size_t limit) { return StringArg::encode(out, s, StringArg::length(s, limit)); }
+    static const char* decode(const uint8_t*& in) { return StringArg::decode(in); }
+};
+
+template<>
+struct Arg<char*> : Arg<const char*> {};
+
+template<typename T>
+using ArgOf = Arg<std::decay_t<T>>;
+
+template<typename... Args>
+struct Decoder {
+    static int format(const char* format, const uint8_t* in, char* out, size_t size) {
+        // braced init runs the decodes left to right
+        std::tuple<decltype(ArgOf<Args>::decode(in))...> values{ArgOf<Args>::decode(in)...};
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+        return std::apply([&](auto... v) { return snprintf(out, size, format, v...); }, values);
+#pragma GCC diagnostic pop
+    }
+};
+
+/// only used in decltype, picks the decoder for the argument types of a call site
+template<typename... Args>
+Decoder<std::decay_t<Args>...> decoderFor(const Args&...);
+
+/// never called, lets the compiler check the format string against the arguments
+inline void checkFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void checkFormat(const char*, ...) {}
+
+}
+
+struct LoggerStats {
+    uint64_t records = 0;
+    /// records which did not fit into their ring
+    uint64_t dropped = 0;
+};
+
+/**
+ * Asynchronous logger. A LOG_* statement checks the level of its subsystem (one relaxed load) and, if enabled, copies
+ * the address of its call site, a timestamp and its binary arguments into a lock free ring of the calling thread.
+ * No formatting, no lock and no syscall on the calling thread. A background thread drains the rings, orders the
+ * records by time, formats them and writes them out. Records which do not fit into the ring are dropped and counted.
+ * Levels are per subsystem and can be changed at any time.
+ */
+class Logger {
+public:
+    ~Logger();
+
+    static Logger& global();
+
+    static bool enabled(LogSubsystem subsystem, LogLevel level) {
+        return (uint8_t)level <= levels_[(size_t)subsystem].load(std::memory_order_relaxed);
+    }
+    static void setLevel(LogSubsystem subsystem, LogLevel level);
+    static LogLevel level(LogSubsystem subsystem);
+    /**
+     * @brief sets levels from a spec like "info,fsm=debug,vesc=trace". A plain level applies to all subsystems
+     * @return false if a part could not be parsed. The other parts are applied anyway
+     **/
+    static bool setLevels(const std::string& spec);
+
+    template<typename... Args>
+    void write(const LogSite& site, const Args&... args) {
+        uint8_t record[sizeof(Header) + LOG_MAX_ARGS_SIZE];
+        size_t len = 0;
+        // every argument gets an equal share of the record, longer strings are cut
+        [[maybe_unused]] size_t limit = LOG_MAX_ARGS_SIZE / (sizeof...(Args) + 1);
+        ((len += logdetail::ArgOf<Args>::size(args, limit)), ...);
+        if (len > LOG_MAX_ARGS_SIZE) {
+            dropped();
+            return;
+        }
+        [[maybe_unused]] uint8_t* out = record + sizeof(Header);
+        ((out = logdetail::ArgOf<Args>::encode(out, args, limit)), ...);
+        commit(site, record, len);
+    }
+
+    /// starts the thread which writes to out
+    void start(FILE* out, std::chrono::milliseconds flushInterval);
+    /// writes everything that is buffered and stops the thread
+    void stop();
+    /// writes everything that is buffered right now
+    void flush();
+
+    LoggerStats stats();
+
+private:
+    struct Header {
+        const LogSite* site;
+        int64_t timestampNs;
+        uint16_t length;
+    };
+
+    struct ThreadRing {
+        RingBuffer<LOG_RING_SIZE> ring;
+        std::atomic<uint64_t> records{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    Logger() = default;
+
+    ThreadRing& threadRing();
+    void commit(const LogSite& site, uint8_t* record, size_t len);
+    void dropped();
+    void run(std::chrono::milliseconds flushInterval);
+
+    static std::atomic<uint8_t> levels_[(size_t)LogSubsystem::count];
+
+    std::mutex m_;
+    std::vector<std::unique_ptr<ThreadRing>> rings_;
+    /// only touched with m_ held
+    FILE* out_ = stdout;
+    std::vector<uint8_t> drainBuffer_;
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+#define LOG_AT(subsystem, level, fmt, ...) \
+    do { \
+        if (Logger::enabled(LogSubsystem::subsystem, level)) { \
+            static const LogSite logSite_{fmt, level, LogSubsystem::subsystem, \
+                                          &decltype(logdetail::decoderFor(__VA_ARGS__))::format}; \
+            Logger::global().write(logSite_, ##__VA_ARGS__); \
+        } \
+        if (false) { \
+            logdetail::checkFormat(fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+/// e.g. LOG_INFO(fsm, "entry %s", name). Arguments are only evaluated if the level is enabled
+#define LOG_ERROR(subsystem, fmt, ...) LOG_AT(subsystem, LogLevel::error, fmt, ##__VA_ARGS__)
+#define LOG_WARN(subsystem, fmt, ...) LOG_AT(subsystem, LogLevel::warn, fmt, ##__VA_ARGS__)
+#define LOG_INFO(subsystem, fmt, ...) LOG_AT(subsystem, LogLevel::info, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(subsystem, fmt, ...) LOG_AT(subsystem, LogLevel::debug, fmt, ##__VA_ARGS__)
+#define LOG_TRACE(subsystem, fmt, ...) LOG_AT(subsystem, LogLevel::trace, fmt, ##__VA_ARGS__)
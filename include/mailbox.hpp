@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Latest-value mailbox for one producer and any number of readers, based on a seqlock.
+ * publish() never blocks and never waits for readers. A reader copies the value and retries if a publish
+ * ran at the same time, so it always gets a consistent snapshot. The value is kept in atomic words,
+ * so the concurrent copy is not a data race.
+ */
+template<typename T>
+class Mailbox {
+    static_assert(std::is_trivially_copyable<T>::value, "Mailbox needs a trivially copyable type");
+    static_assert(std::is_default_constructible<T>::value, "Mailbox needs a default constructible type");
+
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Snapshot {
+        T value{};
+        /// number of publishes up to this value. 0 means nothing was published yet
+        uint64_t seq = 0;
+        /// steady clock time of the publish
+        Clock::time_point timestamp;
+
+        Clock::duration age(Clock::time_point now = Clock::now()) const {
+            return now - timestamp;
+        }
+    };
+
+    Mailbox() {
+        for (auto& word : data_) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// stores a new value. Only one thread may publish to a mailbox
+    void publish(const T& value) {
+        publish(value, Clock::now());
+    }
+
+    /// stores a new value with the given publish time (e.g. a replayed one)
+    void publish(const T& value, Clock::time_point timestamp) {
+        uint64_t words[WORDS] = {};
+        std::memcpy(words, &value, sizeof(T));
+        int64_t stamp = timestamp.time_since_epoch().count();
+
+        uint64_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed); // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            data_[i].store(words[i], std::memory_order_relaxed);
+        }
+        stamp_.store(stamp, std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    /// @return consistent copy of the latest value. seq is 0 if nothing was published yet
+    Snapshot read() const {
+        uint64_t words[WORDS];
+        int64_t stamp;
+        uint64_t before, after;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            while (before & 1) {
+                before = seq_.load(std::memory_order_acquire);
+            }
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = data_[i].load(std::memory_order_relaxed);
+            }
+            stamp = stamp_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq_.load(std::memory_order_relaxed);
+        } while (before != after);
+
+        Snapshot snapshot;
+        std::memcpy(&snapshot.value, words, sizeof(T));
+        snapshot.seq = before / 2;
+        snapshot.timestamp = Clock::time_point(Clock::duration(stamp));
+        return snapshot;
+    }
+
+    /// number of publishes so far. Cheap check for new data without copying the value
+    uint64_t seq() const {
+        return seq_.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    alignas(64) std::atomic<uint64_t> seq_{0};
+    std::atomic<int64_t> stamp_{0};
+    std::atomic<uint64_t> data_[WORDS];
+};
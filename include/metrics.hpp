@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Monotonically increasing count. Threads add to one of a few cache line sized shards, picked once per thread,
+ * so counters bumped on different threads never share a cache line. add() is one relaxed atomic add.
+ */
+class Counter {
+public:
+    static constexpr size_t SHARDS = 8;
+
+    Counter() {
+        for (auto& shard : shards_) {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void add(uint64_t n = 1) {
+        shards_[shard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t sum = 0;
+        for (const auto& shard : shards_) {
+            sum += shard.value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value;
+    };
+
+    static size_t shard() {
+        static std::atomic<size_t> next{0};
+        static thread_local const size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return index;
+    }
+
+    std::array<Shard, SHARDS> shards_;
+};
+
+/// value which can go up and down, e.g. a queue depth
+class Gauge {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * Registry of all runtime metrics, exported as Prometheus text. Components register their counters and gauges
+ * once (usually in their constructor) and keep the reference; registering the same name and labels again returns
+ * the same object, so e.g. two Receivers count into the same series. Values which already exist somewhere else
+ * can be registered as a callback which is read on every export.
+ * The export thread serves the text on a Unix domain socket (one scrape per connection) and/or rewrites a file
+ * for node_exporter's textfile collector. It also turns counters registered with a rate into per second gauges.
+ */
+class Metrics {
+public:
+    enum class Type { counter, gauge };
+
+    Metrics();
+    ~Metrics();
+
+    /// registry used by the drivehub components
+    static Metrics& global();
+
+    /**
+     * @param name - Prometheus metric name, counters end in _total
+     * @param labels - label pairs without braces, e.g. to="fail_safe"
+     * @param rateName - if set, the export thread publishes the per second rate of this counter as gauge rateName
+     **/
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "",
+                     const std::string& rateName = "");
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    /// read runs on the export thread and has to stay valid until the registry is stopped
+    void callback(Type type, const std::string& name, const std::string& help, std::function<double(void)> read,
+                  const std::string& labels = "");
+
+    /// all metrics in the Prometheus text format
+    std::string render();
+
+    /**
+     * @brief starts the export thread
+     * @param socketPath - Unix socket to serve the metrics on, empty for none
+     * @param filePath - file to rewrite every interval, empty for none
+     * @param interval - rate window and file rewrite period
+     * @return false if the socket could not be created. Metrics are not essential, so the caller can go on
+     **/
+    bool start(const std::string& socketPath, const std::string& filePath, std::chrono::milliseconds interval);
+    void stop();
+
+private:
+    struct Series {
+        std::string labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::function<double(void)> read;
+        /// counter this rate series is derived from
+        const Counter* rateOf = nullptr;
+        uint64_t rateLast = 0;
+        double rate = 0;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    Series& series(Type type, const std::string& name, const std::string& help, const std::string& labels, bool& created);
+    void updateRates(double seconds);
+    void writeFile();
+    void run();
+
+    std::mutex m_;
+    /// in registration order, which is also the export order
+    std::vector<std::unique_ptr<Family>> families_;
+
+    std::string socketPath_;
+    std::string filePath_;
+    std::chrono::milliseconds interval_;
+    int listenFd_ = -1;
+    int stopFd_ = -1;
+    std::thread thread_;
+};
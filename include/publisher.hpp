@@ -0,0 +1,365 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "mailbox.hpp"
+#include "metrics.hpp"
+
+/// what a topic does when the publisher thread falls behind
+enum class DropPolicy {
+    /// queue up to depth values, a full queue drops its oldest value
+    dropOldest,
+    /// keep only the newest value, depth is ignored
+    latestWins
+};
+
+/**
+ * Bounded queue for one producer. pop() may run on the consumer and on the producer, the producer pops to drop
+ * the oldest value of a full queue. Every cell carries a sequence number which tells whose turn it is
+ * (Vyukov's bounded queue), so a value is never read while it is written and push/pop never block.
+ */
+template<typename T>
+class DropQueue {
+    static_assert(std::is_trivially_copyable<T>::value, "DropQueue needs a trivially copyable type");
+
+public:
+    /// capacity is rounded up to a power of two
+    explicit DropQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; i++) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// @return false if the queue is full. Only the producer may push
+    bool push(const T& value) {
+        Cell& cell = cells_[tail_ & mask_];
+        if (cell.seq.load(std::memory_order_acquire) != tail_) {
+            return false;
+        }
+        cell.value = value;
+        cell.seq.store(tail_ + 1, std::memory_order_release);
+        tail_++;
+        tailShared_.store(tail_, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief pushes, a full queue drops its oldest value first. Only the producer may push
+     * @return number of values dropped. 2 if the consumer has taken the oldest value but not yet released its cell:
+     * the next oldest one is dropped and the push still fails. Then the new value is dropped as well instead of
+     * popping on, which could empty the whole queue while the consumer is preempted
+     **/
+    size_t pushDropOldest(const T& value) {
+        if (push(value)) {
+            return 0;
+        }
+        T oldest;
+        size_t dropped = pop(oldest) ? 1 : 0;
+        if (push(value)) {
+            return dropped;
+        }
+        return dropped + 1;
+    }
+
+    /// @return false if the queue is empty
+    bool pop(T& value) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            intptr_t diff = (intptr_t)cell.seq.load(std::memory_order_acquire) - (intptr_t)(pos + 1);
+            if (diff < 0) {
+                return false;
+            }
+            if (diff > 0) {
+                pos = head_.load(std::memory_order_relaxed); // the other side popped this one
+                continue;
+            }
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                value = cell.value;
+                cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    /// values in the queue, may be off by the pushes and pops running right now
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tailShared_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    /// producer only
+    alignas(64) size_t tail_ = 0;
+    std::atomic<size_t> tailShared_{0};
+};
+
+/**
+ * When a topic publishes. Rates are per second, 0 turns the limit off.
+ * A value which comes in faster than maxRate is held back and published when the interval is over; a newer value
+ * replaces it. With minRate the last value is published again when nothing was published for 1 / minRate. With a
+ * deadband >= 0 a value is only published if it differs from the last published one by more than the deadband,
+ * measured with the distance function of the topic.
+ */
+struct PublishPolicy {
+    double maxRate = 0;
+    double minRate = 0;
+    double deadband = -1;
+};
+
+/**
+ * Moves publishing off the threads which produce the data. Every topic has a bounded queue (or a latest value
+ * mailbox) which the producer fills without blocking; a dedicated thread drains the topics, applies their
+ * PublishPolicy and runs their publish functions, so a slow link to the iOS device only delays that thread.
+ * The thread sleeps on an eventfd until the next held back value or heartbeat is due and is only woken (one write)
+ * when it went to sleep before a value arrived.
+ * Topics, timers and policies have to be set before start(). Every topic may only be pushed to by one thread.
+ */
+class Publisher {
+public:
+    template<typename T>
+    class Topic;
+
+    /// how far apart two values of a topic are, compared against the deadband
+    template<typename T>
+    using Distance = std::function<double(const T& a, const T& b)>;
+
+    Publisher();
+    ~Publisher();
+
+    /**
+     * @brief adds a topic
+     * @param name - used for policies and as the topic label of the metrics
+     * @param depth - values which can wait for the publisher thread, for dropOldest
+     * @param publish - runs on the publisher thread for every value the policy lets through
+     * @param distance - needed for a deadband
+     **/
+    template<typename T>
+    Topic<T>& addTopic(const std::string& name, size_t depth, DropPolicy policy, std::function<void(const T&)> publish,
+                       Distance<T> distance = nullptr) {
+        auto topic = std::make_unique<Topic<T>>(*this, name, depth, policy, std::move(publish), std::move(distance));
+        Topic<T>& ref = *topic;
+        topics_.push_back(std::move(topic));
+        return ref;
+    }
+
+    /// runs fn on the publisher thread every interval, e.g. to flush a batch which was filled by a topic
+    void addTimer(std::chrono::nanoseconds interval, std::function<void(void)> fn);
+
+    /// @return false if there is no topic with this name
+    bool setPolicy(const std::string& topic, const PublishPolicy& policy);
+    /**
+     * @brief sets policies from a spec like "receiver.max=50,receiver.deadband=0.01,status.min=1".
+     * Keys are max, min and deadband, every part changes one value of the current policy
+     * @return false if a part could not be parsed. The other parts are applied anyway
+     **/
+    bool setPolicies(const std::string& spec);
+
+    void start();
+    /// publishes what is queued, runs every timer once more and stops the thread
+    void stop();
+
+private:
+    class TopicBase {
+    public:
+        TopicBase(const std::string& name)
+            : name_(name),
+              published_(Metrics::global().counter("drivehub_publish_published_total", "values published per topic", "topic=\"" + name + "\"")),
+              dropped_(Metrics::global().counter("drivehub_publish_dropped_total", "values dropped because the publisher fell behind", "topic=\"" + name + "\"")),
+              suppressedRate_(Metrics::global().counter("drivehub_publish_suppressed_total", "values not published because of the topic policy",
+                                                        "topic=\"" + name + "\",reason=\"rate\"")),
+              suppressedDeadband_(Metrics::global().counter("drivehub_publish_suppressed_total", "values not published because of the topic policy",
+                                                            "topic=\"" + name + "\",reason=\"deadband\"")),
+              heartbeats_(Metrics::global().counter("drivehub_publish_heartbeats_total", "values published again because of the minimum rate", "topic=\"" + name + "\"")),
+              depth_(Metrics::global().gauge("drivehub_publish_queue_depth", "values waiting for the publisher thread", "topic=\"" + name + "\"")) {}
+        virtual ~TopicBase() = default;
+
+        /**
+         * @brief takes everything that is queued and publishes what is due
+         * @param nextNs - lowered to the time the topic has something to publish next
+         * @return number of values taken from the queue
+         **/
+        virtual size_t drain(int64_t nowNs, int64_t& nextNs) = 0;
+
+        const std::string name_;
+        PublishPolicy policy_;
+
+    protected:
+        Counter& published_;
+        Counter& dropped_;
+        Counter& suppressedRate_;
+        Counter& suppressedDeadband_;
+        Counter& heartbeats_;
+        Gauge& depth_;
+    };
+
+    /// called by producers after a push
+    void notify() {
+        // pairs with the fence in run(): either the publisher sees the value or we see it sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed) && sleeping_.exchange(false)) {
+            wake();
+        }
+    }
+    void wake();
+    size_t drainAll(int64_t& nextNs);
+    void run();
+
+    struct Timer {
+        int64_t intervalNs;
+        int64_t nextNs;
+        std::function<void(void)> fn;
+    };
+
+    std::vector<std::unique_ptr<TopicBase>> topics_;
+    std::vector<Timer> timers_;
+    int wakeFd_ = -1;
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+template<typename T>
+class Publisher::Topic : public Publisher::TopicBase {
+public:
+    Topic(Publisher& publisher, const std::string& name, size_t depth, DropPolicy policy, std::function<void(const T&)> publish,
+          Distance<T> distance)
+        : TopicBase(name), publisher_(publisher), dropPolicy_(policy), queue_(policy == DropPolicy::dropOldest ? depth : 1),
+          publish_(std::move(publish)), distance_(std::move(distance)) {}
+
+    /// hands a value to the publisher thread, never blocks
+    void push(const T& value) {
+        if (dropPolicy_ == DropPolicy::latestWins) {
+            mailbox_.publish(value);
+        } else {
+            size_t dropped = queue_.pushDropOldest(value);
+            if (dropped > 0) {
+                dropped_.add(dropped);
+            }
+        }
+        publisher_.notify();
+    }
+
+    size_t drain(int64_t nowNs, int64_t& nextNs) override {
+        size_t n = 0;
+        if (dropPolicy_ == DropPolicy::latestWins) {
+            uint64_t seq = mailbox_.seq();
+            if (seq != seen_) {
+                auto snapshot = mailbox_.read();
+                // every publish in between was overwritten
+                if (snapshot.seq > seen_ + 1) {
+                    dropped_.add(snapshot.seq - seen_ - 1);
+                }
+                seen_ = snapshot.seq;
+                offer(snapshot.value, nowNs);
+                n = 1;
+            }
+        } else {
+            depth_.set((int64_t)queue_.size());
+            T value;
+            while (queue_.pop(value)) {
+                offer(value, nowNs);
+                n++;
+            }
+        }
+        due(nowNs, nextNs);
+        return n;
+    }
+
+private:
+    int64_t intervalNs(double rate) const { return rate > 0 ? (int64_t)(1e9 / rate) : 0; }
+
+    void offer(const T& value, int64_t nowNs) {
+        if (hasLast_ && policy_.deadband >= 0 && distance_ && distance_(last_, value) <= policy_.deadband) {
+            // back within the deadband of what the receiver has, a held back value is not needed anymore
+            if (hasHeld_) {
+                hasHeld_ = false;
+                suppressedRate_.add();
+            }
+            suppressedDeadband_.add();
+            return;
+        }
+        if (hasLast_ && nowNs - lastNs_ < intervalNs(policy_.maxRate)) {
+            if (hasHeld_) {
+                suppressedRate_.add();
+            }
+            held_ = value;
+            hasHeld_ = true;
+            return;
+        }
+        hasHeld_ = false;
+        send(value, nowNs);
+    }
+
+    /// publishes a held back value or a heartbeat if it is due, otherwise tells when it will be
+    void due(int64_t nowNs, int64_t& nextNs) {
+        if (hasHeld_) {
+            int64_t at = lastNs_ + intervalNs(policy_.maxRate);
+            if (nowNs >= at) {
+                hasHeld_ = false;
+                send(held_, nowNs);
+            } else {
+                nextNs = std::min(nextNs, at);
+                return;
+            }
+        }
+        int64_t heartbeat = intervalNs(policy_.minRate);
+        if (hasLast_ && heartbeat > 0) {
+            if (nowNs - lastNs_ >= heartbeat) {
+                heartbeats_.add();
+                send(last_, nowNs);
+            }
+            nextNs = std::min(nextNs, lastNs_ + heartbeat);
+        }
+    }
+
+    void send(const T& value, int64_t nowNs) {
+        last_ = value;
+        hasLast_ = true;
+        lastNs_ = nowNs;
+        publish_(value);
+        published_.add();
+    }
+
+    Publisher& publisher_;
+    const DropPolicy dropPolicy_;
+    DropQueue<T> queue_;
+    Mailbox<T> mailbox_;
+    std::function<void(const T&)> publish_;
+    Distance<T> distance_;
+
+    // publisher thread only
+    uint64_t seen_ = 0;
+    T last_{};
+    bool hasLast_ = false;
+    int64_t lastNs_ = 0;
+    /// newest value which came in faster than maxRate
+    T held_{};
+    bool hasHeld_ = false;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <thread>
+
+/**
+ * Single I/O reactor which is shared by all serial devices.
+ * Owns one (epoll backed) io_context which is run by exactly one thread, so the callbacks
+ * of all devices are serialized in the order their operations completed.
+ */
+class Reactor {
+public:
+    using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+
+    Reactor();
+    ~Reactor();
+
+    /**
+     * starts the reactor thread. Can be called after devices are registered and their first
+     * reads are queued.
+     * @param cpu - core the reactor thread is pinned to. Negative value disables pinning
+     **/
+    void start(int cpu = -1);
+
+    /**
+     * stops the io_context and joins the reactor thread. Pending handlers are not executed.
+     **/
+    void stop();
+
+    bool running() const { return running_.load(); }
+
+    boost::asio::io_context& context() { return io_; }
+
+    /// creates a strand for a device. Only needed if handlers of one device must never run concurrently to each other while other threads also run the io_context
+    Strand makeStrand() { return boost::asio::make_strand(io_); }
+
+private:
+    boost::asio::io_context io_;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
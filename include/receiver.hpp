@@ -3,27 +3,15 @@
 #include <cstdint>
 #include "ringbuffer.hpp"
 #include "serial.hpp"
-#include "crc.h"
+#include "sumd_parser.hpp"
 #include "config.h"
+#include "metrics.hpp"
 
-#define MAX_CHAN_COUNT (16)
-#define SUMD_PAKET_MINSIZE (3 + 24 + 2)
-#define MAN_ID (0xA8)
-#define STATE_NORMAL (0x01)
-#define STATE_FS (0x81)
-
-#define THROTTLE_CHANNEL 1
-#define STEERING_CHANNEL 2
-#define GEAR_CHANNEL 3
-#define AUTONOMOUS_CHANNEL 4
-
-struct SumD_Packet{
-    uint8_t manufactureId;
-    uint8_t state;
-    uint8_t numChannels;
-    uint16_t channel[MAX_CHAN_COUNT] = {12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000};
-    uint16_t crc;
-};
+// zero based index into SumD_Packet::channel
+#define THROTTLE_CHANNEL 2
+#define STEERING_CHANNEL 3
+#define GEAR_CHANNEL 4
+#define AUTONOMOUS_CHANNEL 5
 
 enum ReceiverGear {
     undefined, drive, reverse
@@ -37,17 +25,26 @@ struct ReceiverPacket {
     ReceiverGear gearSelector = undefined;
     bool lateral_control = 0;
     bool autonomous = 0;
+    /// CLOCK_MONOTONIC ns at which the last byte of the frame was read
+    int64_t timestampNs = 0;
 };
 
 class Receiver {
 public:
-    Receiver(std::string dev, uint32_t baud);
+    Receiver(Reactor& reactor, std::string dev, uint32_t baud);
+    /// without serial port, bytes are passed in with feed() (replay)
+    Receiver();
     void start();
+    /// processes received bytes as if they came from the serial port at timestampNs
+    void feed(ByteSpan data, int64_t timestampNs = 0);
     void setPacketReceivedCallback(std::function<void(ReceiverPacket packet)> callback);
+
+    /// maps the channels of a SUMD frame onto the control values. Leaves timestampNs alone
+    static void SumD_to_ReceiverPacket(const SumD_Packet& sumd, ReceiverPacket *packet);
 private:
-    static inline float getPercent(SumD_Packet packet, int chan) { return (float)(packet.channel[chan] - 12000) / 3200; }
-    static inline uint16_t getRaw(SumD_Packet packet, int chan) { return packet.channel[chan]; }
-    static inline uint16_t getPPM(SumD_Packet packet, int chan) { return packet.channel[chan] >> 3; }
+    static inline float getPercent(const SumD_Packet& packet, int chan) { return (float)(packet.channel[chan] - 12000) / 3200; }
+    static inline uint16_t getRaw(const SumD_Packet& packet, int chan) { return packet.channel[chan]; }
+    static inline uint16_t getPPM(const SumD_Packet& packet, int chan) { return packet.channel[chan] >> 3; }
 
     static inline float convertSteeringRange(float receiverValue) { return receiverValue * 0.5 + 0.5; }
     static inline float convertThrottleRange(float receiverValue) { return receiverValue * 0.5 + 0.5; }
@@ -55,13 +52,20 @@ private:
 
     void uartReceive(uint8_t* data, size_t size);
     int analyzePacket();
-    uint16_t sumd_crc16(int len);
-    void SumD_to_ReceiverPacket(SumD_Packet sumd, ReceiverPacket *packet);
 private:
     RingBuffer<64> buffer_;
-    uint32_t recvNumChannels = 0;
+    SumdParser parser_;
 
-    SumD_Packet packet;
     std::unique_ptr<Serial> ser;
+    /// read time of the bytes passed to feed()
+    int64_t feedTimeNs_ = 0;
+
+    Counter& frames_ = Metrics::global().counter("drivehub_sumd_frames_total", "valid SUMD frames", "",
+                                                 "drivehub_sumd_frames_per_second");
+    Counter& crcErrors_ = Metrics::global().counter("drivehub_sumd_crc_errors_total", "SUMD frames dropped because of a crc mismatch");
+    Counter& skippedBytes_ = Metrics::global().counter("drivehub_sumd_skipped_bytes_total", "bytes thrown away while resyncing to the SUMD stream");
+    /// parser stats already added to the counters
+    uint32_t crcErrorsSeen_ = 0;
+    uint32_t skippedBytesSeen_ = 0;
     std::function<void(ReceiverPacket packet)> packetReceivedCallback;
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "recorder.hpp"
+
+/// one record of a recording. The payload lives in Recording::data
+struct Record {
+    RecordHeader header;
+    size_t offset;
+};
+
+/// all records of one recorder run, sorted by timestamp
+struct Recording {
+    int64_t run = 0;
+    /// index is the source id
+    std::vector<std::string> sources;
+    std::vector<Record> records;
+    std::vector<uint8_t> data;
+
+    ByteSpan payload(const Record& record) const {
+        return ByteSpan(data.data() + record.offset, record.header.length);
+    }
+
+    /// @return id of the first source whose name starts with prefix, -1 if there is none
+    int findSource(const std::string& prefix) const;
+};
+
+/**
+ * @brief reads the chunk files a Recorder wrote
+ * @param dir - directory of the flight-<index>.bin files
+ * @param out - filled with the records of one run
+ * @param run - run to load (ChunkHeader::run). 0 loads the newest one
+ * @return false if no chunk of the run could be read
+ **/
+bool loadRecording(const std::string& dir, Recording& out, int64_t run = 0);
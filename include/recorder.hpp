@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "ringbuffer.hpp"
+#include "span.hpp"
+
+/// ring per producer thread. Records which do not fit are dropped (and counted), the producer never waits
+#define RECORDER_RING_SIZE (64 * 1024)
+#define RECORDER_FILE_MAGIC 0x52464844 // "DHFR"
+#define RECORDER_FILE_VERSION 1
+
+enum class RecordType : uint8_t {
+    /// end of the records in a chunk (zeroed tail)
+    none = 0,
+    /// source id -> name, at the start of every chunk. Payload is the name
+    source,
+    serialRx,
+    serialTx,
+    receiverPacket,
+    vescData,
+    driveMsg,
+    /// payload: StateId from, StateId to
+    transition,
+};
+
+/// precedes every record in the rings and in the files, followed by length bytes of payload
+struct RecordHeader {
+    /// CLOCK_MONOTONIC
+    int64_t timestampNs;
+    /// per thread sequence number, a gap means records were dropped
+    uint32_t seq;
+    uint16_t length;
+    RecordType type;
+    uint8_t source;
+};
+static_assert(sizeof(RecordHeader) == 16, "RecordHeader is part of the file format");
+
+/// start of every chunk file
+struct ChunkHeader {
+    uint32_t magic = RECORDER_FILE_MAGIC;
+    uint32_t version = RECORDER_FILE_VERSION;
+    uint64_t index;
+    int64_t startNs;
+    /// bytes of records behind this header
+    uint64_t used;
+    /// CLOCK_REALTIME start of the recorder. Same for all chunks of one run
+    int64_t run;
+};
+
+struct RecorderStats {
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    /// records which did not fit into their ring
+    uint64_t dropped = 0;
+    uint64_t chunks = 0;
+};
+
+/**
+ * Always-on flight recorder. Hot paths append records to a lock free ring of their own thread: no lock and no
+ * syscall, only a timestamp (vDSO) and a copy. A background thread drains the rings into memory mapped chunk files
+ * flight-<index>.bin of a fixed size. When the number of chunks exceeds the limit the oldest one is deleted, so
+ * disk usage is bounded by maxChunks * chunkSize.
+ */
+class Recorder {
+public:
+    /**
+     * @param dir - directory for the chunk files. Is created if it does not exist
+     * @param chunkSize - size of one chunk file in bytes
+     * @param maxChunks - number of chunk files kept on disk
+     **/
+    Recorder(const std::string& dir, size_t chunkSize, size_t maxChunks);
+    ~Recorder();
+
+    /// starts the flush thread and makes this the recorder returned by active()
+    bool start(std::chrono::milliseconds flushInterval);
+    void stop();
+
+    /// recorder the hot paths write to, nullptr if none is running
+    static Recorder* active() {
+        return active_.load(std::memory_order_acquire);
+    }
+
+    /// id for a named source (e.g. a serial port). Not meant for hot paths
+    uint8_t sourceId(const std::string& name);
+
+    /// appends a record to the ring of the calling thread. Payload is truncated to 64 KiB
+    void record(RecordType type, uint8_t source, ByteSpan payload);
+
+    template<typename T>
+    void recordValue(RecordType type, uint8_t source, const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be recorded");
+        record(type, source, ByteSpan(reinterpret_cast<const uint8_t*>(&value), sizeof(T)));
+    }
+
+    /// drains all rings into the chunk file right now (the flush thread does this periodically)
+    void flush();
+
+    RecorderStats stats();
+
+private:
+    struct ThreadRing {
+        RingBuffer<RECORDER_RING_SIZE> ring;
+        uint32_t seq = 0;
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    ThreadRing& threadRing();
+    void run(std::chrono::milliseconds flushInterval);
+    size_t drain(ThreadRing& ring);
+    bool openChunk();
+    void closeChunk();
+    void writeSources();
+    void append(const RecordHeader& header, ByteSpan first, ByteSpan second);
+
+    static std::atomic<Recorder*> active_;
+    static std::atomic<uint64_t> nextId_;
+
+    const uint64_t id_;
+    int64_t run_;
+
+    std::string dir_;
+    size_t chunkSize_;
+    size_t maxChunks_;
+
+    std::mutex m_;
+    std::vector<std::unique_ptr<ThreadRing>> rings_;
+    std::vector<std::string> sources_;
+
+    // only touched by the flush thread
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t offset_ = 0;
+    uint64_t chunkIndex_ = 0;
+    uint64_t firstChunk_ = 0;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> records_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> chunks_{0};
+};
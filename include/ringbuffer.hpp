@@ -4,68 +4,152 @@
 #undef min
 #undef max
 #include <stdio.h>
+#include <string.h>
 #include <array>
+#include <atomic>
 
+#include "span.hpp"
+
+/**
+ * Lock free single producer single consumer byte ring.
+ * Read and write positions are free running and indexed with a mask, so a full buffer can be
+ * distinguished from an empty one. Bytes which do not fit anymore are dropped and counted as overflow.
+ * Only one thread may write (write, push) and only one thread may read (read, peekContiguous, operator[], pop).
+ */
 template <size_t SIZE_ = 256>
 class RingBuffer
 {
+    static_assert(SIZE_ > 0 && (SIZE_ & (SIZE_ - 1)) == 0, "RingBuffer size has to be a power of two");
+    static constexpr size_t MASK = SIZE_ - 1;
+
 public:
-    std::array<unsigned char, SIZE_> buffer;
-    int writePos;
-    int readPos;
+    /// readable bytes split at the wrap around point. second is empty if the bytes do not wrap
+    struct Spans {
+        ByteSpan first;
+        ByteSpan second;
+        size_t size() const { return first.size() + second.size(); }
+    };
 
 public:
     /**
      * @brief Constructor
      **/
-    RingBuffer() : writePos(0), readPos(0) {}
+    RingBuffer() : writePos(0), overflowCount(0), readPos(0) {}
 
     /**
-     * @brief retrieves the object on position pos in the RingBuffer
-     * @param pos - position in buffer relative to readPosition
-     * @return char - the char at the pos
+     * @brief copies as many bytes as fit into the buffer. The rest is dropped and counted as overflow
+     * @param data - bytes to append
+     * @return number of bytes written
      **/
-    unsigned char operator[](int pos)
+    size_t write(ByteSpan data)
     {
-        if(pos < available())
-        {
-            return buffer[(readPos + pos) % SIZE_];
-        } else
-        {
-            return -1; // could be normal value
+        size_t w = writePos.load(std::memory_order_relaxed);
+        size_t r = readPos.load(std::memory_order_acquire);
+        size_t n = SIZE_ - (w - r);
+        if (data.size() < n) n = data.size();
+        if (n < data.size()) {
+            overflowCount.store(overflowCount.load(std::memory_order_relaxed) + data.size() - n, std::memory_order_relaxed);
         }
+        size_t idx = w & MASK;
+        size_t head = SIZE_ - idx;
+        if (head > n) head = n;
+        memcpy(&buffer[idx], data.data(), head);
+        if (n > head) memcpy(&buffer[0], data.data() + head, n - head);
+        writePos.store(w + n, std::memory_order_release);
+        return n;
     }
 
     /**
-     * @brief pops items from the buffer
-     * @param count - number of items to pop
+     * @brief pushes one item to buffer
+     * @param c - next item
+     * @return false if the buffer was full and the item got dropped
      **/
-    void pop(int count = 1)
+    bool push(uint8_t c)
     {
-        if(count > available())
-        {
-            readPos = writePos;
-        } else
-        {
-            readPos = (readPos + count) % SIZE_;
-        }
+        return write(ByteSpan(&c, 1)) == 1;
     }
 
     /**
-     * @brief pushes one item to buffer
-     * @param c - next item
+     * @brief copies bytes out of the buffer and pops them
+     * @param out - destination. At most out.size() bytes are read
+     * @return number of bytes read
+     **/
+    size_t read(MutableByteSpan out)
+    {
+        Spans spans = peekContiguous();
+        size_t n = spans.size() < out.size() ? spans.size() : out.size();
+        size_t head = spans.first.size() < n ? spans.first.size() : n;
+        memcpy(out.data(), spans.first.data(), head);
+        if (n > head) memcpy(out.data() + head, spans.second.data(), n - head);
+        pop(n);
+        return n;
+    }
+
+    /**
+     * @brief view on all readable bytes without copying them. Stays valid until the bytes are popped
+     * @return up to two spans; second one is only set if the bytes wrap around the end of the buffer
+     **/
+    Spans peekContiguous() const
+    {
+        size_t r = readPos.load(std::memory_order_relaxed);
+        size_t n = writePos.load(std::memory_order_acquire) - r;
+        size_t idx = r & MASK;
+        size_t head = SIZE_ - idx;
+        if (head > n) head = n;
+        return Spans{ByteSpan(&buffer[idx], head), ByteSpan(&buffer[0], n - head)};
+    }
+
+    /**
+     * @brief retrieves the object on position pos in the RingBuffer. Not bounds checked
+     * @param pos - position in buffer relative to readPosition, has to be smaller than available()
+     * @return char - the char at the pos
+     **/
+    uint8_t operator[](size_t pos) const
+    {
+        return buffer[(readPos.load(std::memory_order_relaxed) + pos) & MASK];
+    }
+
+    /**
+     * @brief pops items from the buffer
+     * @param count - number of items to pop. Is clamped to available()
      **/
-    void push(char c)
+    void pop(size_t count = 1)
     {
-        buffer[writePos] = c;
-        writePos = (writePos + 1) % SIZE_;
+        size_t r = readPos.load(std::memory_order_relaxed);
+        size_t n = writePos.load(std::memory_order_acquire) - r;
+        if (count > n) count = n;
+        readPos.store(r + count, std::memory_order_release);
     }
 
     /**
-     * @brief checks if buffer has at least one item
+     * @brief checks how many items are in the buffer
      * @return number of items in buffer
      **/
-    int available() { return (SIZE_ + writePos - readPos) % SIZE_; }
+    size_t available() const
+    {
+        // read position first, so the difference can not underflow when called from a third thread
+        size_t r = readPos.load(std::memory_order_acquire);
+        return writePos.load(std::memory_order_acquire) - r;
+    }
+
+    /// number of items which can be written before the buffer is full
+    size_t space() const { return SIZE_ - available(); }
+
+    bool empty() const { return available() == 0; }
+
+    bool full() const { return available() == SIZE_; }
+
+    /// number of bytes dropped since construction because the buffer was full
+    size_t overflows() const { return overflowCount.load(std::memory_order_relaxed); }
+
+    static constexpr size_t capacity() { return SIZE_; }
+
+private:
+    // producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<size_t> writePos;
+    std::atomic<size_t> overflowCount;
+    alignas(64) std::atomic<size_t> readPos;
+    alignas(64) std::array<uint8_t, SIZE_> buffer;
 };
 
 #endif
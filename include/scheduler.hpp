@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+struct SchedulerStats {
+    uint64_t fired = 0;
+    uint64_t wakeups = 0;
+};
+
+/**
+ * Runs all timers on one thread. Deadlines are kept in a min-heap; the thread sleeps until the earliest one.
+ * Every timer owns a slot with a generation counter. Re-arming or cancelling only bumps the generation, which
+ * turns the entries of the previous arming into stale ones that are dropped when they reach the top of the heap.
+ * Callbacks run without the lock held and may arm or cancel any timer, including their own.
+ */
+class Scheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// scheduler shared by all Timer objects. Stays alive as long as one of them holds it
+    static std::shared_ptr<Scheduler> shared();
+
+    Scheduler();
+    ~Scheduler();
+
+    /// @return id of a new, unarmed timer slot
+    int create();
+    /// cancels the timer and releases its slot
+    void destroy(int id);
+
+    /**
+     * @brief (re-)arms a timer. A previous arming of the same timer is cancelled
+     * @param delay - time until the first call
+     * @param interval - period of the following calls. Zero fires only once
+     **/
+    void arm(int id, std::function<void(void)> function, Clock::duration delay, Clock::duration interval);
+
+    /**
+     * @brief cancels a timer. If its callback is running on the scheduler thread, waits until it returned
+     * (unless called from the callback itself), so the callback will not be running after this returns
+     **/
+    void cancel(int id);
+
+    SchedulerStats stats();
+
+private:
+    struct Slot {
+        std::function<void(void)> function;
+        Clock::duration interval;
+        uint64_t generation = 0;
+        bool armed = false;
+    };
+
+    struct Entry {
+        Clock::time_point deadline;
+        int id;
+        uint64_t generation;
+        bool operator>(const Entry& other) const { return deadline > other.deadline; }
+    };
+
+    void run();
+
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::condition_variable idle_;
+    std::vector<Slot> slots_;
+    std::vector<int> freeSlots_;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap_;
+    /// slot whose callback is running right now, -1 if none
+    int running_ = -1;
+    bool active_ = true;
+    SchedulerStats stats_;
+    std::thread thread_;
+};
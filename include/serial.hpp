@@ -3,15 +3,26 @@
 #include <vector>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
-#include <boost/thread.hpp>
+
+#include "clock.hpp"
+#include "reactor.hpp"
+#include "recorder.hpp"
 
 #define BUF_LEN 64
 
+/**
+ * serial device which is registered with a shared Reactor. Receive callbacks are executed on the reactor thread.
+ * If useStrand is set, all handlers of this device are additionally serialized through an own strand.
+ * Received and written bytes go to the flight recorder if one is running.
+ */
 class Serial
 {
 public:
-    Serial(const std::string& port, const unsigned int baud_rate)
-    try : io(), serial(io,port)
+    /// name tags the port in the flight recorder (e.g. "receiver"), so a replay can find its bytes
+    Serial(Reactor& reactor, const std::string& port, const unsigned int baud_rate, bool useStrand = false, const std::string& name = "")
+    try : serial(reactor.context(), port),
+          executor(useStrand ? boost::asio::any_io_executor(reactor.makeStrand()) : boost::asio::any_io_executor(reactor.context().get_executor())),
+          source(Recorder::active() ? Recorder::active()->sourceId(name.empty() ? port : name + ":" + port) : 0)
     {
         using namespace boost::asio;
         serial.set_option(serial_port_base::baud_rate(baud_rate));
@@ -52,37 +63,72 @@ public:
     // }
     
     void handleRecieve(const boost::system::error_code& error, size_t bytes_transferred) {
+        if (error == boost::asio::error::operation_aborted) {
+            return; // reactor or port was shut down
+        }
         if (bytes_transferred > 0) {
+            receiveTimeNs = monotonicNs();
+            if (Recorder* recorder = Recorder::active()) {
+                recorder->record(RecordType::serialRx, source, ByteSpan(buf, bytes_transferred));
+            }
             callback_(buf, bytes_transferred);
         }
 //        boost::asio::async_read(serial, boost::asio::buffer(buf,BUF_LEN), boost::bind(&Serial::handleRecieve,
 //                                                                              this, boost::asio::placeholders::error,
 //                                                                              boost::asio::placeholders::bytes_transferred));
-        serial.async_read_some(boost::asio::buffer(buf,BUF_LEN), boost::bind(&Serial::handleRecieve,
+        serial.async_read_some(boost::asio::buffer(buf,BUF_LEN), boost::asio::bind_executor(executor, boost::bind(&Serial::handleRecieve,
                                                                        this, boost::asio::placeholders::error,
-                                                                       boost::asio::placeholders::bytes_transferred));
+                                                                       boost::asio::placeholders::bytes_transferred)));
     }
     
+    /// queues the first read. Reading starts as soon as the reactor runs
     void startAsync(std::function<void(uint8_t* data, size_t size)> callback) {
         callback_ = callback;
         boost::system::error_code error;
 //        boost::asio::async_read(serial, boost::asio::buffer(buf,BUF_LEN), boost::bind(&Serial::handleRecieve,
 //                                                                              this, boost::asio::placeholders::error,
 //                                                                              boost::asio::placeholders::bytes_transferred));
-        serial.async_read_some(boost::asio::buffer(buf,BUF_LEN), boost::bind(&Serial::handleRecieve,
+        serial.async_read_some(boost::asio::buffer(buf,BUF_LEN), boost::asio::bind_executor(executor, boost::bind(&Serial::handleRecieve,
                                                                        this, boost::asio::placeholders::error,
-                                                                       boost::asio::placeholders::bytes_transferred));
-        boost::thread t(boost::bind(&boost::asio::io_service::run, &io));
-        //io.run();
+                                                                       boost::asio::placeholders::bytes_transferred)));
     }
     
     void writeBytes(uint8_t* data, int len) {
+        if (Recorder* recorder = Recorder::active()) {
+            recorder->record(RecordType::serialTx, source, ByteSpan(data, len));
+        }
         serial.write_some(boost::asio::buffer(data, len));
     }
 
+    /// writes all buffers (gathered into as few syscalls as possible), handler runs on the reactor thread. Buffers have to stay valid until then
+    template <typename ConstBufferSequence, typename WriteHandler>
+    void asyncWrite(const ConstBufferSequence& buffers, WriteHandler handler) {
+        if (Recorder* recorder = Recorder::active()) {
+            for (auto it = boost::asio::buffer_sequence_begin(buffers); it != boost::asio::buffer_sequence_end(buffers); ++it) {
+                boost::asio::const_buffer buffer(*it);
+                recorder->record(RecordType::serialTx, source, ByteSpan(static_cast<const uint8_t*>(buffer.data()), buffer.size()));
+            }
+        }
+        boost::asio::async_write(serial, buffers, boost::asio::bind_executor(executor, handler));
+    }
+
+    /// CLOCK_MONOTONIC ns at which the bytes passed to the running receive callback were read
+    int64_t lastReceiveTime() const {
+        return receiveTimeNs;
+    }
+
+    /// runs handler on the reactor thread (in this device's strand if it has one)
+    template <typename Handler>
+    void post(Handler handler) {
+        boost::asio::post(executor, handler);
+    }
+
 private:
-    boost::asio::io_service io;
     boost::asio::serial_port serial;
+    boost::asio::any_io_executor executor;
+    /// id of this port in the flight recorder
+    uint8_t source;
     uint8_t buf[BUF_LEN];
+    int64_t receiveTimeNs = 0;
     std::function<void(uint8_t* data, size_t size)> callback_;
 };
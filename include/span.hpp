@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * non owning view on a contiguous sequence of elements (stand-in for std::span, which is C++20)
+ */
+template <typename T>
+class Span
+{
+public:
+    constexpr Span() : ptr_(nullptr), len_(0) {}
+    constexpr Span(T* ptr, size_t len) : ptr_(ptr), len_(len) {}
+    template <size_t N>
+    constexpr Span(T (&arr)[N]) : ptr_(arr), len_(N) {}
+    /// allows Span<uint8_t> to be passed where a Span<const uint8_t> is expected
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+    constexpr Span(const Span<U>& other) : ptr_(other.data()), len_(other.size()) {}
+
+    constexpr T* data() const { return ptr_; }
+    constexpr size_t size() const { return len_; }
+    constexpr bool empty() const { return len_ == 0; }
+    constexpr T& operator[](size_t pos) const { return ptr_[pos]; }
+    constexpr T* begin() const { return ptr_; }
+    constexpr T* end() const { return ptr_ + len_; }
+
+    /**
+     * @brief view on a part of this span. Is clamped to the size of this span
+     **/
+    constexpr Span subspan(size_t offset, size_t count = SIZE_MAX) const {
+        if (offset > len_) offset = len_;
+        if (count > len_ - offset) count = len_ - offset;
+        return Span(ptr_ + offset, count);
+    }
+
+private:
+    T* ptr_;
+    size_t len_;
+};
+
+using ByteSpan = Span<const uint8_t>;
+using MutableByteSpan = Span<uint8_t>;
@@ -5,35 +5,65 @@
 #include "swiftrobotc/msgs.h"
 #include "receiver.hpp"
 
+#include <cstdint>
+
 class Context;
 
-class BaseState {
-protected:
-    Context* context_;
-public:
-    virtual ~BaseState() {
+/// order has to match the alternatives of Context::State
+enum class StateId : uint8_t {
+    setup,
+    manualWaiting,
+    manualControl,
+    lateralControl,
+    autonomous,
+    failSafe,
+    count
+};
 
+/// snake case name of a state, e.g. for metric labels
+constexpr const char* stateName(StateId state) {
+    switch (state) {
+        case StateId::setup: return "setup";
+        case StateId::manualWaiting: return "manual_waiting";
+        case StateId::manualControl: return "manual_control";
+        case StateId::lateralControl: return "lateral_control";
+        case StateId::autonomous: return "autonomous";
+        case StateId::failSafe: return "fail_safe";
+        default: return "unknown";
     }
+}
 
+/// input signals. What they do in every state is declared in states/transitions.hpp
+enum class Signal : uint8_t {
+    manualControl,
+    autonomousControl,
+    lateralControl,
+    receiverTimedOut,
+    receiverMotorReset,
+    swiftrobotTimedOut,
+    receiverConnected,
+    count
+};
+
+/**
+ * Common part of all states. States are held by value in a std::variant and called through std::visit,
+ * so nothing here is virtual: a state only declares the hooks it needs and hides the empty defaults.
+ * Transitions are not handled by the states, they are looked up in the transition table.
+ */
+class BaseState {
+protected:
+    Context* context_ = nullptr;
+public:
     void set_context(Context* context) {
         this->context_ = context;
     }
 
-    virtual void exit() = 0;
-    virtual void entry() = 0;
+    void exit() {}
+    void entry() {}
 
      // update events
-    virtual void ReceiverPacketUpdated(ReceiverPacket packet) = 0;
-    virtual void DriveMsgUpdated(control_msg::Drive msg) = 0;
-
-    // input signals
-    virtual void manualControl() = 0;
-    virtual void autonomousControl() = 0;
-    virtual void lateralControl() = 0;
-    virtual void receiverTimedOut() = 0;
-    virtual void receiverMotorReset() = 0;
-    virtual void swiftrobotTimedOut() = 0;
-    virtual void receiverConnected() = 0;
+    void ReceiverPacketUpdated(ReceiverPacket) {}
+    void DriveMsgUpdated(control_msg::Drive) {}
 };
 
-#endif
\ No newline at end of file
+#endif
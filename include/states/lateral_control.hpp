@@ -3,17 +3,8 @@
 #include "base_state.hpp"
 
 class Lateral_Control: public BaseState {
-    void exit() override;
-    void entry() override; 
-    
-    void ReceiverPacketUpdated(ReceiverPacket packet) override;
-    void DriveMsgUpdated(control_msg::Drive msg) override; 
-    
-    void manualControl() override;
-    void autonomousControl() override;
-    void lateralControl() override;
-    void receiverTimedOut() override;
-    void receiverMotorReset() override;
-    void swiftrobotTimedOut() override;
-    void receiverConnected() override;
+public:
+    void entry();
+    void ReceiverPacketUpdated(ReceiverPacket packet);
+    void DriveMsgUpdated(control_msg::Drive msg);
 };
@@ -0,0 +1,90 @@
+#ifndef TRANSITIONS_HPP
+#define TRANSITIONS_HPP
+
+#include "base_state.hpp"
+
+#include <array>
+#include <cstddef>
+
+enum class Guard : uint8_t {
+    none,
+    /// only taken while the iOS device is connected
+    swiftrobotConnected
+};
+
+struct Transition {
+    StateId from;
+    Signal signal;
+    StateId to;
+    Guard guard = Guard::none;
+    /// go back to the state before the last transition instead of 'to'
+    bool toHistory = false;
+};
+
+/// every (state, signal) pair which is not listed here is ignored
+constexpr Transition transitions[] = {
+    {StateId::setup,          Signal::manualControl,      StateId::manualWaiting},
+    {StateId::setup,          Signal::autonomousControl,  StateId::autonomous,     Guard::swiftrobotConnected},
+    {StateId::setup,          Signal::lateralControl,     StateId::lateralControl, Guard::swiftrobotConnected},
+    {StateId::setup,          Signal::receiverTimedOut,   StateId::failSafe},
+
+    {StateId::manualWaiting,  Signal::autonomousControl,  StateId::autonomous,     Guard::swiftrobotConnected},
+    {StateId::manualWaiting,  Signal::lateralControl,     StateId::lateralControl, Guard::swiftrobotConnected},
+    {StateId::manualWaiting,  Signal::receiverTimedOut,   StateId::failSafe},
+    {StateId::manualWaiting,  Signal::receiverMotorReset, StateId::manualControl},
+
+    {StateId::manualControl,  Signal::autonomousControl,  StateId::autonomous,     Guard::swiftrobotConnected},
+    {StateId::manualControl,  Signal::lateralControl,     StateId::lateralControl, Guard::swiftrobotConnected},
+    {StateId::manualControl,  Signal::receiverTimedOut,   StateId::failSafe},
+
+    {StateId::lateralControl, Signal::manualControl,      StateId::manualWaiting},
+    {StateId::lateralControl, Signal::autonomousControl,  StateId::autonomous,     Guard::swiftrobotConnected},
+    {StateId::lateralControl, Signal::receiverTimedOut,   StateId::failSafe},
+
+    {StateId::autonomous,     Signal::manualControl,      StateId::manualWaiting},
+    {StateId::autonomous,     Signal::lateralControl,     StateId::lateralControl, Guard::swiftrobotConnected},
+    {StateId::autonomous,     Signal::receiverTimedOut,   StateId::failSafe},
+    {StateId::autonomous,     Signal::swiftrobotTimedOut, StateId::manualWaiting},
+
+    {StateId::failSafe,       Signal::receiverConnected,  StateId::failSafe,       Guard::none, true},
+};
+
+struct TransitionEntry {
+    bool valid = false;
+    StateId to = StateId::setup;
+    Guard guard = Guard::none;
+    bool toHistory = false;
+};
+
+using TransitionTable = std::array<std::array<TransitionEntry, (size_t)Signal::count>, (size_t)StateId::count>;
+
+/// dense [state][signal] lookup table built from the list above
+constexpr TransitionTable makeTransitionTable() {
+    TransitionTable table{};
+    for (const Transition& t : transitions) {
+        TransitionEntry& entry = table[(size_t)t.from][(size_t)t.signal];
+        entry.valid = true;
+        entry.to = t.to;
+        entry.guard = t.guard;
+        entry.toHistory = t.toHistory;
+    }
+    return table;
+}
+
+constexpr bool transitionsUnique() {
+    constexpr size_t count = sizeof(transitions) / sizeof(transitions[0]);
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = i + 1; j < count; j++) {
+            if (transitions[i].from == transitions[j].from && transitions[i].signal == transitions[j].signal) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(transitionsUnique(), "more than one transition for the same state and signal");
+
+constexpr TransitionTable transitionTable = makeTransitionTable();
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "receiver.hpp"
+#include "vesc.hpp"
+
+#include "swiftrobotc/msgs.h"
+
+#include <cstdint>
+
+#define VESC_STATUS_MSG_SIZE 6
+#define RECEIVER_MSG_SIZE 5
+
+/**
+ * The messages are filled in place, so a message which is kept per topic only allocates on the first fill.
+ * A message must only be filled and published by one thread at a time.
+ */
+
+/// SR_STATUS: fet temp and motor temp (0.1 C), rpm, input voltage (0.1 V), tachometer, tachometer abs. Same scales as the VESC
+void vescStatusMsg(const VescData& data, base_msg::UInt32Array& msg);
+
+/// SR_RECEIVER: throttle and steering (0 - 65000), gear (0 = undefined, 1 = drive, 2 = reverse), lateral control, autonomous
+void receiverPacketMsg(const ReceiverPacket& packet, base_msg::UInt16Array& msg);
+
+/// deadband distance for SR_STATUS: largest relative change of temperatures, rpm and voltage. Any tachometer change counts
+double vescStatusDistance(const VescData& a, const VescData& b);
+
+/// deadband distance for SR_RECEIVER: largest change of throttle or steering. Any gear or mode change counts
+double receiverPacketDistance(const ReceiverPacket& a, const ReceiverPacket& b);
+
+/**
+ * @brief publishes msg without copying it. swiftrobotc takes the message as a deduced by value parameter;
+ * naming the type as a const reference turns that parameter into a reference to msg
+ **/
+template<typename Client, typename Msg>
+void publishInPlace(Client& client, uint16_t channel, const Msg& msg) {
+    client.template publish<const Msg&>(channel, msg);
+}
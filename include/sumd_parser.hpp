@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include "span.hpp"
+
+#define MAX_CHAN_COUNT (16)
+#define MAN_ID (0xA8)
+#define STATE_NORMAL (0x01)
+#define STATE_FS (0x81)
+
+struct SumD_Packet{
+    uint8_t manufactureId;
+    uint8_t state;
+    uint8_t numChannels;
+    uint16_t channel[MAX_CHAN_COUNT] = {12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000};
+    uint16_t crc;
+};
+
+/**
+ * Resumable SUMD decoder. Bytes are fed as they arrive and every byte is looked at exactly once:
+ * header -> status -> channel count -> channel data -> crc. The crc is updated while the frame comes in.
+ * If a frame turns out to be broken the decoder starts looking for the next header behind it, so
+ * resyncing after line noise is linear in the number of bytes.
+ */
+class SumdParser {
+public:
+    SumdParser();
+
+    /**
+     * @brief feeds bytes into the decoder
+     * @param data - next bytes of the stream
+     * @return number of valid frames completed. The last one can be read with packet()
+     **/
+    int feed(ByteSpan data);
+
+    /**
+     * @brief feeds one byte into the decoder
+     * @return true if this byte completed a valid frame
+     **/
+    bool push(uint8_t byte);
+
+    /// last valid frame
+    const SumD_Packet& packet() const { return packet_; }
+
+    /// drops a partially received frame
+    void reset();
+
+    /// frames dropped because of a crc mismatch
+    uint32_t crcErrors() const { return crcErrors_; }
+    /// bytes thrown away while searching for the next frame (including bytes of broken frames)
+    uint32_t skippedBytes() const { return skippedBytes_; }
+
+private:
+    enum class Step { header, status, numChannels, channelHigh, channelLow, crcHigh, crcLow };
+
+    bool startFrame(uint8_t byte);
+    void dropFrame();
+
+    Step step_;
+    uint16_t crc_;
+    uint8_t channelIdx_;
+    /// bytes of the frame in progress
+    uint16_t frameLen_;
+    SumD_Packet frame_;
+    SumD_Packet packet_;
+    uint32_t crcErrors_;
+    uint32_t skippedBytes_;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "receiver.hpp"
+#include "span.hpp"
+#include "vesc.hpp"
+
+#define TELEMETRY_VERSION 1
+/// header: version, flags, sample count (u16), timestamp of the first sample in ns (i64)
+#define TELEMETRY_HEADER_SIZE 12
+/// kind, time delta and six fields, each as varint of at most 5 bytes
+#define TELEMETRY_MAX_SAMPLE_SIZE (1 + 5 + 6 * 5)
+
+enum class TelemetryKind : uint8_t {
+    receiver = 0,
+    vesc = 1
+};
+
+/// one timestamped sample, as it is queued between the serial threads and the publisher thread
+struct TelemetrySample {
+    TelemetryKind kind = TelemetryKind::receiver;
+    /// CLOCK_MONOTONIC ns
+    int64_t timestampNs = 0;
+    ReceiverPacket receiver;
+    VescData vesc;
+};
+
+/**
+ * Packs samples into one compact frame for SR_TELEMETRY. Little endian:
+ *   u8 version, u8 flags (0), u16 sample count, i64 timestamp of the first sample (ns, CLOCK_MONOTONIC)
+ *   per sample: u8 kind, zigzag varint time since the previous sample in us (can be negative, the sources stamp
+ *   their samples themselves), then the fields of the kind as zigzag varints, each the difference to the same
+ *   field of the previous sample of that kind in this frame (0 for the first one)
+ * receiver fields: throttle, steering (0 - 65000), gear, lateral control | autonomous << 1
+ * vesc fields: fet temp, motor temp (0.1 C), rpm, voltage (0.1 V), tachometer, tachometer abs. Same scales as SR_STATUS
+ * Every frame can be decoded on its own. Slowly changing values take one or two bytes per field.
+ */
+class TelemetryEncoder {
+public:
+    /// @param maxSamples - frame is full after this many samples
+    explicit TelemetryEncoder(size_t maxSamples);
+
+    /**
+     * @brief appends a sample to the frame in out. An empty out starts a new frame, so clearing out after it was
+     * sent starts the next one without giving up its capacity
+     **/
+    void add(const TelemetrySample& sample, std::vector<uint8_t>& out);
+    /// samples in the current frame
+    size_t samples() const { return samples_; }
+    bool full() const { return samples_ >= maxSamples_; }
+
+    /// bytes needed for a frame of maxSamples
+    size_t capacity() const { return TELEMETRY_HEADER_SIZE + maxSamples_ * TELEMETRY_MAX_SAMPLE_SIZE; }
+
+private:
+    size_t maxSamples_;
+    size_t samples_ = 0;
+    int64_t lastUs_ = 0;
+    int32_t lastReceiver_[4] = {};
+    int32_t lastVesc_[6] = {};
+};
+
+/// @return false if the frame is malformed. samples is cleared first
+bool decodeTelemetryFrame(ByteSpan frame, std::vector<TelemetrySample>& samples);
@@ -1,26 +1,30 @@
 #ifndef TIMER_HPP
 #define TIMER_HPP
 
-#include <iostream>
-#include <thread>
-#include <chrono>
-#include <atomic>
 #include <functional>
-#include <mutex>
-#include <condition_variable>
+#include <memory>
 
+#include "scheduler.hpp"
+
+/**
+ * One shot or periodic timer. All timers share one Scheduler thread, so arming and stopping
+ * does not create or join threads
+ */
 class Timer {
     private:
-        std::atomic<bool> active{true};
-        std::thread t;
-        std::mutex m;
-        std::condition_variable cv;
-	
+        std::shared_ptr<Scheduler> scheduler;
+        int id;
+
     public:
+        Timer();
+        ~Timer();
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
         void setTimeout(std::function<void(void)> function, int delay);
         void setInterval(std::function<void(void)> function, int interval);
         void stop();
 
 };
 
-#endif
\ No newline at end of file
+#endif
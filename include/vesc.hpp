@@ -2,13 +2,17 @@
 #define SIMPLE_VESC_HPP
 
 #include "serial.hpp"
-#include "ringbuffer.hpp"
+#include "vesc_frame.hpp"
+#include "vesc_tx.hpp"
 #include "config.h"
+#include "metrics.hpp"
 
 #include <chrono>
 
-#define VESC_PACKET_MAXSIZE 259
-#define VESC_PACKET_MINSIZE 5
+/// fields requested with COMM_GET_VALUES_SELECTIVE: fet temp, motor temp, rpm, input voltage, tachometer, tachometer abs
+#define VESC_VALUES_MASK ((1 << 0) | (1 << 1) | (1 << 7) | (1 << 8) | (1 << 13) | (1 << 14))
+/// id + mask + 3 * f16 + 3 * i32
+#define VESC_VALUES_PAYLOAD_SIZE (1 + 4 + 3 * 2 + 3 * 4)
 
 struct VescData {
     float mosfet_temp = 0;
@@ -21,32 +25,51 @@ struct VescData {
 
 class Vesc {
 public:
-    Vesc(std::string dev, uint32_t baud);
+    Vesc(Reactor& reactor, std::string dev, uint32_t baud);
+    /// without serial port (replay): payloads are handed to txSink instead of being sent, received bytes come in with feed()
+    explicit Vesc(std::function<void(ByteSpan payload)> txSink);
     void start();
+    /// processes received bytes as if they came from the serial port
+    void feed(ByteSpan data);
     void setStatusReceivedCallback(std::function<void(VescData data)> callback);
 
     /// assert in range [0.0 , 1.0]
-    void setDutyCycle(float duty);
-    void setCurrent(float current);
-    void setCurrentBrake(float current);
+    void setDutyCycle(float duty, VescTxClass cls = VescTxClass::setpoint);
+    void setCurrent(float current, VescTxClass cls = VescTxClass::setpoint);
+    void setCurrentBrake(float current, VescTxClass cls = VescTxClass::emergency);
     /// assert in range [0.0 , 1.0]
-    void setServoPos(float pos);
-    void requestState();
+    void setServoPos(float pos, VescTxClass cls = VescTxClass::setpoint);
+    /// @return false if the request could not be queued
+    bool requestState();
+
+    /// nullptr without serial port
+    const VescTxQueue* txQueue() const { return tx_.get(); }
 
     VescData data;
 
 private:
-    void sendPaket(uint8_t* payload, int len);
+    bool sendPaket(uint8_t* payload, int len, VescTxClass cls, bool latestWins = false);
     void uartReceive(uint8_t* buffer, int buflen); // standard timeout is 10 ms
     int analyzePacket();
-    uint16_t vesc_crc16(int start, int len);
+    void handlePayload(ByteSpan payload);
+    bool decodeValuesSelective(ByteSpan payload);
 
-    float unpack_f16(float scale, int& idx);
-    int32_t unpack_i32(int& idx);
+    static float unpack_f16(ByteSpan payload, float scale, int& idx);
+    static int32_t unpack_i32(ByteSpan payload, int& idx);
 private:
     std::unique_ptr<Serial> ser;
-    RingBuffer<VESC_PACKET_MAXSIZE> buffer_;
+    std::unique_ptr<VescTxQueue> tx_;
+    std::function<void(ByteSpan payload)> txSink_;
+    VescFrameDecoder decoder_;
     std::function<void(VescData data)> statusReceivedCallback;
+
+    Counter& frames_ = Metrics::global().counter("drivehub_vesc_frames_total", "valid frames received from the VESC", "",
+                                                 "drivehub_vesc_frames_per_second");
+    Counter& crcErrors_ = Metrics::global().counter("drivehub_vesc_crc_errors_total", "VESC frames dropped because of a crc mismatch");
+    Counter& skippedBytes_ = Metrics::global().counter("drivehub_vesc_skipped_bytes_total", "bytes thrown away while resyncing to the VESC stream");
+    /// decoder stats already added to the counters
+    uint32_t crcErrorsSeen_ = 0;
+    uint32_t skippedBytesSeen_ = 0;
 };
 
 #endif  // SIMPLE_VESC_HPP
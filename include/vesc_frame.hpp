@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include "ringbuffer.hpp"
+#include "span.hpp"
+
+#define VESC_FRAME_START_SHORT 0x02 // 1 byte payload length
+#define VESC_FRAME_START_LONG 0x03 // 2 byte payload length
+#define VESC_FRAME_END 0x03
+/// largest payload the VESC firmware sends (PACKET_MAX_PL_LEN)
+#define VESC_PAYLOAD_MAXSIZE 512
+/// start byte + up to 2 length bytes + 2 crc bytes + end byte
+#define VESC_FRAME_OVERHEAD_MAX 6
+#define VESC_FRAME_MAXSIZE (VESC_PAYLOAD_MAXSIZE + VESC_FRAME_OVERHEAD_MAX)
+/// rx ring size; next power of two which holds the largest frame
+#define VESC_BUFFER_SIZE 1024
+
+/**
+ * @brief frames a payload. Payloads up to 255 bytes get the short (0x02) framing, longer ones the long (0x03) framing
+ * @param payload - command id followed by its arguments
+ * @param out - destination, should hold payload.size() + VESC_FRAME_OVERHEAD_MAX bytes
+ * @return length of the frame in out, 0 if the payload is empty or does not fit
+ **/
+size_t vescEncodeFrame(ByteSpan payload, MutableByteSpan out);
+
+/**
+ * Splits the byte stream of the VESC into frames (short and long framing).
+ * Bytes stay in the rx ring until a frame is complete, its end byte matches and its crc is valid; only
+ * then the payload is handed out. Candidates are rejected by their length and end byte before any crc is
+ * computed. While the candidate in front is incomplete, the bytes behind it are searched for a complete
+ * valid frame, so a stray start byte with a plausible length does not hold back the following frames until
+ * up to VESC_FRAME_MAXSIZE bytes arrived. That search rescans the buffered bytes on every next() which finds
+ * no frame, so resyncing costs up to one pass over the ring per received chunk, not one pass over the stream.
+ * Payloads are handed out as a span into the ring. Only frames which wrap around the end of the ring are
+ * copied into a frame buffer first.
+ */
+class VescFrameDecoder {
+public:
+    VescFrameDecoder();
+
+    /**
+     * @brief appends received bytes
+     * @return number of bytes accepted. The rest is dropped and counted by overflows()
+     **/
+    size_t write(ByteSpan data) { return buffer_.write(data); }
+
+    /**
+     * @brief looks for the next valid frame
+     * @param payload - set to the payload (command id + data) of the frame. Stays valid until the next call
+     * @return false if no complete frame is buffered
+     **/
+    bool next(ByteSpan& payload);
+
+    /// frames which had a valid length and end byte, but a wrong crc
+    uint32_t crcErrors() const { return crcErrors_; }
+    /// bytes thrown away while searching for the next frame
+    uint32_t skippedBytes() const { return skippedBytes_; }
+    /// bytes lost because the rx ring was full
+    size_t overflows() const { return buffer_.overflows(); }
+
+private:
+    enum class Candidate { incomplete, invalid, badCrc, valid };
+
+    Candidate check(size_t offset, size_t avail, size_t& header, size_t& len);
+    size_t findBehind(size_t avail);
+    void skip(size_t count);
+    ByteSpan contiguous(size_t offset, size_t len);
+
+    RingBuffer<VESC_BUFFER_SIZE> buffer_;
+    /// size of the frame handed out by the last next(), popped on the following call
+    size_t consumed_;
+    /// payload of a frame which wraps around the end of the ring
+    uint8_t frame_[VESC_PAYLOAD_MAXSIZE];
+    uint32_t crcErrors_;
+    uint32_t skippedBytes_;
+};
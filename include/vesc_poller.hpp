@@ -0,0 +1,105 @@
+#pragma once
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "latency_histogram.hpp"
+#include "metrics.hpp"
+#include "reactor.hpp"
+#include "vesc.hpp"
+
+/// requests which may wait for their answer at the same time
+#define VESC_POLL_MAX_IN_FLIGHT 2
+/// short framing adds start, length, 2 crc and end byte
+#define VESC_POLL_REQUEST_FRAME_SIZE (5 + 5)
+#define VESC_POLL_ANSWER_FRAME_SIZE (VESC_VALUES_PAYLOAD_SIZE + 5)
+
+struct VescPollerStats {
+    uint64_t requests = 0;
+    uint64_t answers = 0;
+    /// requests which were not answered within the timeout
+    uint64_t timeouts = 0;
+    /// answers which came in within the timeout after a request was given up, taken as its late answer
+    uint64_t late = 0;
+    /// answers which came in while no request was waiting
+    uint64_t unmatched = 0;
+    double rate = 0;
+};
+
+/**
+ * Polls the VESC state with COMM_GET_VALUES_SELECTIVE on the reactor thread. At most VESC_POLL_MAX_IN_FLIGHT requests
+ * wait for an answer; a tick which finds all of them outstanding is skipped, so a slow or silent VESC never piles up
+ * requests in front of the control commands. The VESC answers in order and its answers carry no id, so an answer
+ * belongs to the oldest waiting request; their distance is the round trip time. A request which timed out may still
+ * be answered, ahead of the waiting ones: that many answers within one timeout after the give up are dropped as late
+ * instead of being paired. If the given up request was never answered, this costs the next request its pairing (it
+ * times out as well) but never yields a wrong round trip time.
+ * The rate follows the car: the moving rate while the rpm is above a threshold (and for a while after), the idle rate
+ * otherwise. Both are capped to what the link can carry next to the control commands.
+ * All methods have to run on the reactor thread, except start().
+ */
+class VescPoller {
+public:
+    struct Config {
+        double idleRate;
+        double movingRate;
+        /// |rpm| above which the car counts as moving
+        int32_t movingRpm;
+        /// stays at the moving rate for this long after the car stopped
+        std::chrono::nanoseconds movingHold;
+        std::chrono::nanoseconds timeout;
+        uint32_t baud;
+        /// part of the tx direction the requests may use, the rest is left to the control commands
+        double txShare;
+        /// part of the rx direction the answers may use, they are the only traffic there
+        double rxShare;
+    };
+
+    VescPoller(Reactor& reactor, Vesc& vesc, const Config& config);
+
+    /// starts polling at the idle rate
+    void start();
+    /// hand every VESC state answer to the poller
+    void answered(const VescData& data);
+
+    /// highest rate the link allows for polls
+    double maxRate() const { return maxRate_; }
+    /// round trip times of answered requests, read from any thread
+    const LatencyHistogram& rtt() const { return rtt_; }
+    VescPollerStats stats() const;
+
+private:
+    void schedule();
+    void tick();
+
+    Vesc& vesc_;
+    Config config_;
+    boost::asio::steady_timer timer_;
+    double maxRate_;
+    double rate_;
+    /// monotonicNs() of the next tick
+    int64_t nextNs_ = 0;
+    /// a reschedule invalidates a wait whose handler is already queued
+    uint64_t timerGeneration_ = 0;
+
+    /// send times of the waiting requests, oldest first
+    std::array<int64_t, VESC_POLL_MAX_IN_FLIGHT> inFlight_;
+    size_t inFlightHead_ = 0;
+    size_t inFlightCount_ = 0;
+    int64_t lastMovingNs_ = INT64_MIN / 2;
+    /// given up requests whose answers may still come in, until lateUntilNs_
+    size_t lateExpected_ = 0;
+    int64_t lateUntilNs_ = 0;
+
+    LatencyHistogram rtt_;
+    Counter& requests_ = Metrics::global().counter("drivehub_vesc_poll_requests_total", "VESC state requests sent");
+    Counter& answers_ = Metrics::global().counter("drivehub_vesc_poll_answers_total", "VESC state answers paired with a request");
+    Counter& timeouts_ = Metrics::global().counter("drivehub_vesc_poll_timeouts_total", "VESC state requests without an answer");
+    Counter& late_ = Metrics::global().counter("drivehub_vesc_poll_late_total", "VESC state answers to requests which had timed out");
+    Counter& unmatched_ = Metrics::global().counter("drivehub_vesc_poll_unmatched_total", "VESC state answers without a waiting request");
+    Counter& skipped_ = Metrics::global().counter("drivehub_vesc_poll_skipped_total", "poll ticks skipped because all requests were in flight");
+    Gauge& rateGauge_ = Metrics::global().gauge("drivehub_vesc_poll_rate_hz", "current VESC poll rate");
+};
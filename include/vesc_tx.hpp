@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include "latency_histogram.hpp"
+#include "metrics.hpp"
+#include "serial.hpp"
+#include "vesc_frame.hpp"
+
+/// number of preallocated frames which can be queued or in flight at the same time
+#define VESC_TX_POOL_SIZE 16
+
+/// priority of a VESC command, highest first
+enum class VescTxClass : uint8_t {
+    /// brake and fail safe commands
+    emergency,
+    /// duty and servo of the control loop
+    setpoint,
+    /// state requests of the poller
+    telemetry,
+    /// reads of the VESC configuration
+    config,
+    count
+};
+
+/// snake case name of a class, e.g. for metric labels
+constexpr const char* vescTxClassName(VescTxClass cls) {
+    switch (cls) {
+        case VescTxClass::emergency: return "emergency";
+        case VescTxClass::setpoint: return "setpoint";
+        case VescTxClass::telemetry: return "telemetry";
+        case VescTxClass::config: return "config";
+        default: return "unknown";
+    }
+}
+
+/**
+ * Non blocking transmit queue for VESC commands.
+ * send() frames the payload into a preallocated slot and returns right away; the actual write runs on the
+ * reactor thread. All frames which are queued when the write starts go out in one gathered async write,
+ * so e.g. servo and duty of one control step share a single writev. Commands sent with latestWins replace
+ * a queued, not yet written command with the same id. Partial writes are continued by async_write.
+ * Every write takes the queued frames by class, highest first and in order within a class. The bytes handed to the
+ * port are limited by a budget which refills at the line rate, up to one cycle's worth: the port only buffers what
+ * the line drains within a cycle, so a brake command never waits behind a backlog in the tty buffer. Emergency
+ * and setpoint frames are never held back but spend the budget, telemetry and config frames wait until it
+ * covers them.
+ * send() can be called from any thread.
+ */
+class VescTxQueue {
+public:
+    /**
+     * @param baud - line rate the budget refills at
+     * @param cycle - the budget holds at most the bytes of one cycle
+     **/
+    VescTxQueue(Reactor& reactor, Serial& ser, uint32_t baud, std::chrono::nanoseconds cycle);
+
+    /**
+     * @brief queues a command
+     * @param payload - command id followed by its arguments
+     * @param latestWins - replace a queued command with the same id instead of queuing a second one. The replaced
+     * command moves to cls
+     * @return false if the payload could not be framed or all slots are in use
+     **/
+    bool send(ByteSpan payload, VescTxClass cls, bool latestWins);
+
+    /// frames handed to the serial port
+    uint64_t framesSent() const { return framesSent_.value(); }
+    uint64_t bytesSent() const { return bytesSent_.value(); }
+    /// gathered writes, each covering one or more frames
+    uint64_t writes() const { return writes_.value(); }
+    /// commands which replaced a queued one
+    uint64_t coalesced() const { return coalesced_.value(); }
+    /// commands dropped because the pool was exhausted
+    uint64_t dropped() const { return dropped_.value(); }
+    uint64_t writeErrors() const { return writeErrors_.value(); }
+    /// frames which had to wait for the budget
+    uint64_t deferred() const { return deferred_.value(); }
+    /// bytes the budget holds at most
+    double budget() const { return budget_; }
+
+    /// time from send() to the write which carries the frame, per class. Read from any thread
+    const LatencyHistogram& queueLatency(VescTxClass cls) const { return queueLatency_[(size_t)cls]; }
+
+private:
+    struct Slot {
+        uint8_t frame[VESC_FRAME_MAXSIZE];
+        size_t len;
+        uint8_t command;
+        bool latestWins;
+        VescTxClass cls;
+        /// CLOCK_MONOTONIC ns of the send()
+        int64_t queuedNs;
+        /// already counted as deferred
+        bool deferred;
+    };
+
+    struct Pending {
+        std::array<uint8_t, VESC_TX_POOL_SIZE> slots;
+        size_t count = 0;
+    };
+
+    void flush();
+    void handleWrite(const boost::system::error_code& error, size_t bytes_transferred);
+    /// waits until the budget covers the first held back frame. m_ has to be held
+    void armBudgetTimer(size_t bytes);
+
+    Serial& ser_;
+    std::mutex m_;
+    std::array<Slot, VESC_TX_POOL_SIZE> slots_;
+    // slot indices
+    std::array<uint8_t, VESC_TX_POOL_SIZE> free_;
+    size_t freeCount_;
+    /// per class, oldest first
+    std::array<Pending, (size_t)VescTxClass::count> pending_;
+    size_t pendingCount_;
+    std::array<uint8_t, VESC_TX_POOL_SIZE> inFlight_;
+    size_t inFlightCount_;
+    std::array<boost::asio::const_buffer, VESC_TX_POOL_SIZE> buffers_;
+    /// a flush is posted to the reactor, but did not run yet
+    bool flushScheduled_;
+    bool writing_;
+
+    // budget, reactor thread only
+    const double bytesPerNs_;
+    const double budget_;
+    /// bytes which can be written right now, negative after urgent frames overdrew it
+    double tokens_;
+    int64_t refilledNs_;
+    boost::asio::steady_timer budgetTimer_;
+    bool budgetTimerArmed_ = false;
+
+    std::array<LatencyHistogram, (size_t)VescTxClass::count> queueLatency_;
+
+    Counter& framesSent_ = Metrics::global().counter("drivehub_vesc_tx_frames_total", "frames handed to the VESC port");
+    Counter& bytesSent_ = Metrics::global().counter("drivehub_vesc_tx_bytes_total", "bytes written to the VESC port", "",
+                                                    "drivehub_vesc_tx_bytes_per_second");
+    Counter& writes_ = Metrics::global().counter("drivehub_vesc_tx_writes_total", "gathered writes to the VESC port");
+    Counter& coalesced_ = Metrics::global().counter("drivehub_vesc_tx_coalesced_total", "VESC commands which replaced a queued one");
+    Counter& dropped_ = Metrics::global().counter("drivehub_vesc_tx_dropped_total", "VESC commands dropped because the tx pool was full");
+    Counter& writeErrors_ = Metrics::global().counter("drivehub_vesc_tx_write_errors_total", "failed writes to the VESC port");
+    Counter& deferred_ = Metrics::global().counter("drivehub_vesc_tx_deferred_total", "VESC frames which waited for the byte budget");
+    /// frames queued or in flight
+    Gauge& depth_ = Metrics::global().gauge("drivehub_vesc_tx_queue_depth", "VESC frames queued or being written");
+};
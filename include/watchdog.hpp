@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct WatchdogStats {
+    uint64_t trips = 0;
+    /// time between the deadline and the timeout callback, measured on the first trip after a heartbeat
+    int64_t lastLatencyNs = 0;
+    int64_t maxLatencyNs = 0;
+};
+
+/**
+ * Deadline watchdog. Every heartbeat source has its own timerfd on CLOCK_MONOTONIC which is re-armed by
+ * feed(). A dedicated thread sleeps in epoll until one of the deadlines passes, so a timeout is detected
+ * right at the deadline instead of at the next poll. While a source stays silent, its callback is repeated
+ * once per timeout period.
+ */
+class Watchdog {
+public:
+    Watchdog();
+    ~Watchdog();
+
+    /**
+     * @brief registers a heartbeat source. Has to be called before start()
+     * @param timeout - maximum time between two heartbeats
+     * @param onTimeout - runs on the watchdog thread when the deadline passed
+     * @return id of the source for feed() and stats()
+     **/
+    int addSource(std::chrono::nanoseconds timeout, std::function<void(void)> onTimeout);
+
+    /// arms all sources (first deadline is one timeout from now) and starts the watchdog thread
+    void start();
+    void stop();
+
+    /// heartbeat of a source: moves its deadline to one timeout from now. Can be called from any thread
+    void feed(int source);
+
+    WatchdogStats stats(int source) const;
+
+private:
+    struct Source {
+        int fd;
+        int64_t timeoutNs;
+        std::function<void(void)> onTimeout;
+        std::atomic<int64_t> deadlineNs{0};
+        /// set by the first trip after a heartbeat, only that one is used for the latency
+        std::atomic<bool> tripped{false};
+        std::atomic<uint64_t> trips{0};
+        std::atomic<int64_t> lastLatencyNs{0};
+        std::atomic<int64_t> maxLatencyNs{0};
+    };
+
+    void arm(Source& source);
+    void run();
+
+    int epollFd_;
+    int stopFd_;
+    std::vector<std::unique_ptr<Source>> sources_;
+    std::thread thread_;
+    std::atomic<bool> active_{false};
+};
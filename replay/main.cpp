@@ -0,0 +1,85 @@
+#include "replay.hpp"
+#include "vesc_commands.hpp"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void usage(const char* name) {
+    printf("usage: %s [--speed X] [--run ID] DIR\n"
+           "  DIR      directory with the flight-<index>.bin chunks\n"
+           "  --speed  1 keeps the recorded timing, 0 runs as fast as possible (default 0)\n"
+           "  --run    run to replay (ChunkHeader::run), default is the newest\n", name);
+}
+
+static void printDiff(const char* name, const ReplayDiff& diff) {
+    printf("%-26s recorded %8lu replayed %8lu mismatched %8lu", name,
+           (unsigned long)diff.recorded, (unsigned long)diff.replayed, (unsigned long)diff.mismatched);
+    if (diff.firstMismatchNs >= 0) {
+        printf("  first at %.3f s", diff.firstMismatchNs / 1e9);
+    }
+    printf("\n");
+}
+
+static const char* commandName(uint8_t command) {
+    switch (command) {
+    case COMM_SET_DUTY: return "COMM_SET_DUTY";
+    case COMM_SET_CURRENT: return "COMM_SET_CURRENT";
+    case COMM_SET_CURRENT_BRAKE: return "COMM_SET_CURRENT_BRAKE";
+    case COMM_SET_SERVO_POS: return "COMM_SET_SERVO_POS";
+    default: return "other command";
+    }
+}
+
+/**
+ * Replays a flight recording through the drivehub stack and compares the outputs with the recorded ones.
+ * Exits with 1 if they differ, so it can be used for regression tests.
+ */
+int main(int argc, char** argv) {
+    double speed = 0.0;
+    int64_t run = 0;
+
+    static const option options[] = {
+        {"speed", required_argument, nullptr, 's'},
+        {"run", required_argument, nullptr, 'r'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:r:h", options, nullptr)) != -1) {
+        switch (opt) {
+        case 's': speed = atof(optarg); break;
+        case 'r': run = atoll(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Recording recording;
+    if (!loadRecording(argv[optind], recording, run)) {
+        printf("no recording found in '%s'\n", argv[optind]);
+        return 2;
+    }
+    printf("run %lld: %zu records\n", (long long)recording.run, recording.records.size());
+
+    Replay replay(recording);
+    ReplayResult result;
+    if (!replay.run(speed, result)) {
+        return 2;
+    }
+
+    for (const auto& command : result.vescCommands) {
+        printDiff(commandName(command.first), command.second);
+    }
+    printDiff("transitions", result.transitions);
+    printDiff("receiver packets", result.receiverPackets);
+    printDiff("vesc values", result.vescValues);
+    printf("%lu events, %.2f s recorded in %.3f s (%.0fx real time)\n", (unsigned long)result.events,
+           result.recordedSeconds, result.wallSeconds,
+           result.wallSeconds > 0 ? result.recordedSeconds / result.wallSeconds : 0.0);
+    printf(result.equal() ? "outputs match the recording\n" : "outputs differ from the recording\n");
+    return result.equal() ? 0 : 1;
+}
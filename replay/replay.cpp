@@ -0,0 +1,243 @@
+#include "replay.hpp"
+
+#include "clock.hpp"
+#include "config.h"
+#include "drive_core.hpp"
+#include "vesc_commands.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+enum class EventType {
+    receiverBytes,
+    vescBytes,
+    driveMsg,
+    /// control loop tick, at the time the recorded setpoints were sent
+    tick,
+};
+
+struct Event {
+    int64_t timestampNs;
+    EventType type;
+    size_t record;
+};
+
+struct Output {
+    int64_t timestampNs;
+    std::vector<uint8_t> bytes;
+};
+
+/// compares two output streams position by position
+ReplayDiff compare(const std::vector<Output>& recorded, const std::vector<Output>& replayed, int64_t startNs) {
+    ReplayDiff diff;
+    diff.recorded = recorded.size();
+    diff.replayed = replayed.size();
+    size_t n = std::min(recorded.size(), replayed.size());
+    for (size_t i = 0; i < n; i++) {
+        if (recorded[i].bytes != replayed[i].bytes) {
+            if (diff.mismatched == 0) {
+                diff.firstMismatchNs = recorded[i].timestampNs - startNs;
+            }
+            diff.mismatched++;
+        }
+    }
+    if (diff.firstMismatchNs < 0 && recorded.size() != replayed.size()) {
+        const std::vector<Output>& longer = recorded.size() > replayed.size() ? recorded : replayed;
+        diff.firstMismatchNs = longer[n].timestampNs - startNs;
+    }
+    return diff;
+}
+
+Output output(int64_t timestampNs, ByteSpan bytes) {
+    return Output{timestampNs, std::vector<uint8_t>(bytes.begin(), bytes.end())};
+}
+
+template<typename T>
+Output output(int64_t timestampNs, const T& value) {
+    return output(timestampNs, ByteSpan(reinterpret_cast<const uint8_t*>(&value), sizeof(T)));
+}
+
+/// ReceiverPacket up to its last control value. The padding is not initialized and the read time is not compared
+ByteSpan packetBytes(ByteSpan packet) {
+    return ByteSpan(packet.data(), std::min(packet.size(), offsetof(ReceiverPacket, autonomous) + sizeof(bool)));
+}
+
+}
+
+bool ReplayResult::equal() const {
+    for (const auto& command : vescCommands) {
+        if (!command.second.equal()) {
+            return false;
+        }
+    }
+    return transitions.equal() && receiverPackets.equal() && vescValues.equal();
+}
+
+Replay::Replay(const Recording& recording) : recording_(recording) {}
+
+bool Replay::run(double speed, ReplayResult& result) {
+    int receiverSource = recording_.findSource("receiver");
+    int vescSource = recording_.findSource("vesc");
+    if (receiverSource < 0 || vescSource < 0 || recording_.records.empty()) {
+        printf("Replay: recording has no receiver or vesc port\n");
+        return false;
+    }
+
+    // expected outputs and the input / timing events
+    std::map<uint8_t, std::vector<Output>> recordedCommands;
+    std::vector<Output> recordedTransitions, recordedPackets, recordedValues;
+    std::vector<Event> events;
+    VescFrameDecoder txDecoder;
+    for (size_t i = 0; i < recording_.records.size(); i++) {
+        const RecordHeader& header = recording_.records[i].header;
+        ByteSpan payload = recording_.payload(recording_.records[i]);
+        switch (header.type) {
+        case RecordType::serialRx:
+            if (header.source == receiverSource) {
+                events.push_back(Event{header.timestampNs, EventType::receiverBytes, i});
+            } else if (header.source == vescSource) {
+                events.push_back(Event{header.timestampNs, EventType::vescBytes, i});
+            }
+            break;
+        case RecordType::serialTx: {
+            if (header.source != vescSource) {
+                break;
+            }
+            txDecoder.write(payload);
+            ByteSpan command;
+            while (txDecoder.next(command)) {
+                // state requests come from the VescPoller, which replay does not run: when it polls depends on
+                // when the VESC answered, firing them at the recorded times would only compare them with themselves
+                if (command[0] == COMM_GET_VALUES_SELECTIVE) {
+                    continue;
+                }
+                recordedCommands[command[0]].push_back(output(header.timestampNs, command));
+                // every tick starts with the servo position
+                if (command[0] == COMM_SET_SERVO_POS) {
+                    events.push_back(Event{header.timestampNs, EventType::tick, i});
+                }
+            }
+            break;
+        }
+        case RecordType::driveMsg:
+            events.push_back(Event{header.timestampNs, EventType::driveMsg, i});
+            break;
+        case RecordType::transition:
+            recordedTransitions.push_back(output(header.timestampNs, payload));
+            break;
+        case RecordType::receiverPacket:
+            recordedPackets.push_back(output(header.timestampNs, packetBytes(payload)));
+            break;
+        case RecordType::vescData:
+            recordedValues.push_back(output(header.timestampNs, payload));
+            break;
+        default:
+            break;
+        }
+    }
+    // inputs of the same instant go first, like the recorded tick saw them
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        if (a.timestampNs != b.timestampNs) {
+            return a.timestampNs < b.timestampNs;
+        }
+        return a.type < b.type;
+    });
+
+    // the drivehub without its ports, time comes from the records
+    const int64_t startNs = recording_.records.front().header.timestampNs;
+    int64_t now = startNs;
+    std::map<uint8_t, std::vector<Output>> replayedCommands;
+    std::vector<Output> replayedTransitions, replayedPackets, replayedValues;
+
+    std::shared_ptr<SwiftRobotClient> swiftrobotclient;
+    std::shared_ptr<LEDController> ledcontroller = std::make_shared<LEDController>();
+    std::shared_ptr<Receiver> receiver = std::make_shared<Receiver>();
+    std::shared_ptr<Vesc> vesc = std::make_shared<Vesc>([&](ByteSpan payload) {
+        replayedCommands[payload[0]].push_back(output(now, payload));
+    });
+    Context context(StateId::setup, swiftrobotclient, vesc, receiver, ledcontroller);
+    DriveCore core(context, [&]() { return now; });
+
+    int64_t receiverDeadline = now + std::chrono::nanoseconds(TIMEOUT_HARDWARE).count();
+    receiver->setPacketReceivedCallback([&](ReceiverPacket packet) {
+        replayedPackets.push_back(output(now, packetBytes(ByteSpan(reinterpret_cast<const uint8_t*>(&packet), sizeof(packet)))));
+        receiverDeadline = now + std::chrono::nanoseconds(TIMEOUT_HARDWARE).count();
+        core.receiverInput(packet);
+    });
+    vesc->setStatusReceivedCallback([&](VescData data) {
+        replayedValues.push_back(output(now, data));
+    });
+
+    context.transitionObserver = [&](StateId from, StateId to) {
+        uint8_t transition[2] = {(uint8_t)from, (uint8_t)to};
+        replayedTransitions.push_back(output(now, ByteSpan(transition, 2)));
+    };
+
+    // same start up as main
+    context.swiftrobotConnected = true;
+    context.manualControl();
+
+    const int64_t wallStart = monotonicNs();
+    const int64_t timeout = std::chrono::nanoseconds(TIMEOUT_HARDWARE).count();
+    for (const Event& event : events) {
+        // heartbeat timeouts which passed before this event. Repeated every period, like the Watchdog
+        while (receiverDeadline < event.timestampNs) {
+            now = receiverDeadline;
+            core.receiverTimedOut();
+            receiverDeadline += timeout;
+        }
+        now = event.timestampNs;
+        if (speed > 0) {
+            int64_t wallTarget = wallStart + (int64_t)((now - startNs) / speed);
+            int64_t wait = wallTarget - monotonicNs();
+            if (wait > 0) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+            }
+        }
+
+        const Record& record = recording_.records[event.record];
+        switch (event.type) {
+        case EventType::receiverBytes:
+            receiver->feed(recording_.payload(record), now);
+            break;
+        case EventType::vescBytes:
+            vesc->feed(recording_.payload(record));
+            break;
+        case EventType::driveMsg: {
+            control_msg::Drive msg;
+            ByteSpan payload = recording_.payload(record);
+            if (payload.size() == sizeof(msg)) {
+                memcpy(&msg, payload.data(), sizeof(msg));
+                core.driveInput(msg);
+            }
+            break;
+        }
+        case EventType::tick:
+            core.tick();
+            break;
+        }
+        result.events++;
+    }
+
+    for (const auto& command : recordedCommands) {
+        result.vescCommands[command.first] = compare(command.second, replayedCommands[command.first], startNs);
+    }
+    for (const auto& command : replayedCommands) {
+        if (result.vescCommands.count(command.first) == 0) {
+            result.vescCommands[command.first] = compare({}, command.second, startNs);
+        }
+    }
+    result.transitions = compare(recordedTransitions, replayedTransitions, startNs);
+    result.receiverPackets = compare(recordedPackets, replayedPackets, startNs);
+    result.vescValues = compare(recordedValues, replayedValues, startNs);
+    result.recordedSeconds = (recording_.records.back().header.timestampNs - startNs) / 1e9;
+    result.wallSeconds = (monotonicNs() - wallStart) / 1e9;
+    return true;
+}
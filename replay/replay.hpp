@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "record_reader.hpp"
+
+/// comparison of one output stream of the replay with the recording
+struct ReplayDiff {
+    uint64_t recorded = 0;
+    uint64_t replayed = 0;
+    /// entries at the same position which differ
+    uint64_t mismatched = 0;
+    /// time of the first difference relative to the start of the recording, -1 if there is none
+    int64_t firstMismatchNs = -1;
+
+    bool equal() const { return recorded == replayed && mismatched == 0; }
+};
+
+struct ReplayResult {
+    /// per VESC command id
+    std::map<uint8_t, ReplayDiff> vescCommands;
+    ReplayDiff transitions;
+    ReplayDiff receiverPackets;
+    ReplayDiff vescValues;
+
+    uint64_t events = 0;
+    double recordedSeconds = 0;
+    double wallSeconds = 0;
+
+    bool equal() const;
+};
+
+/**
+ * Runs the recorded serial bytes and drive messages through Receiver, Vesc, DriveCore and the FSM again, on a
+ * virtual clock that follows the record timestamps. Control loop ticks happen at the recorded times, heartbeat
+ * timeouts are evaluated on the virtual clock. The VESC commands, FSM transitions and decoded packets it produces
+ * are compared with the ones in the recording. VESC state requests are not: they come from the VescPoller, which
+ * replay does not run. The recorded answers are decoded all the same.
+ */
+class Replay {
+public:
+    explicit Replay(const Recording& recording);
+
+    /**
+     * @param speed - 1.0 keeps the recorded timing, 2.0 runs twice as fast, 0 runs as fast as possible
+     * @return false if the recording has no receiver or vesc source
+     **/
+    bool run(double speed, ReplayResult& result);
+
+private:
+    const Recording& recording_;
+};
@@ -0,0 +1,128 @@
+#include "pty.hpp"
+#include "sumd_sim.hpp"
+#include "vesc_sim.hpp"
+#include "motor_model.hpp"
+#include "receiver.hpp"
+
+#include <getopt.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static std::atomic<bool> running{true};
+
+static void handleSignal(int) {
+    running = false;
+}
+
+static void usage(const char* name) {
+    printf("usage: %s [--rate HZ] [--noise P] [--duration S] [--time-scale X]\n"
+           "  --rate      SUMD frames per second (default 100)\n"
+           "  --noise     probability that a frame is disturbed, 0.0 - 1.0 (default 0)\n"
+           "  --duration  seconds until exit, 0 runs until SIGINT (default 0)\n"
+           "  --time-scale  simulated seconds of the motor model per real second (default 1)\n", name);
+}
+
+/**
+ * Creates a receiver and a VESC pty, prints their paths and streams SUMD frames until stopped.
+ * Start the drivehub with --receiver and --vesc pointing at the printed paths.
+ */
+int main(int argc, char** argv) {
+    int rate = 100;
+    double noise = 0.0;
+    int duration = 0;
+    double timeScale = 1.0;
+
+    static const option options[] = {
+        {"rate", required_argument, nullptr, 'r'},
+        {"noise", required_argument, nullptr, 'n'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"time-scale", required_argument, nullptr, 't'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:n:d:t:h", options, nullptr)) != -1) {
+        switch (opt) {
+        case 'r': rate = atoi(optarg); break;
+        case 'n': noise = atof(optarg); break;
+        case 'd': duration = atoi(optarg); break;
+        case 't': timeScale = atof(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+
+    Pty receiverPty;
+    Pty vescPty;
+    printf("receiver: %s\nvesc: %s\n", receiverPty.path().c_str(), vescPty.path().c_str());
+    printf("run: robocar_drivehub --receiver %s --vesc %s\n", receiverPty.path().c_str(), vescPty.path().c_str());
+    fflush(stdout);
+
+    SumdSimulator sumd(receiverPty.fd());
+    // manual mode, drive gear, throttle released so the drivehub leaves manual waiting
+    sumd.setChannel(THROTTLE_CHANNEL, SUMD_SIM_LOW);
+    sumd.setChannel(GEAR_CHANNEL, SUMD_SIM_HIGH);
+    sumd.setChannel(AUTONOMOUS_CHANNEL, SUMD_SIM_LOW);
+    sumd.start(rate, noise);
+
+    VescSimulator vesc(vescPty.fd());
+    vesc.setModel(std::make_unique<MotorModel>());
+    vesc.start();
+
+    // advances the motor model once per millisecond by timeScale milliseconds
+    std::thread model([&]() {
+        timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        while (running.load()) {
+            vesc.advance(0.001 * timeScale);
+            next.tv_nsec += 1000000;
+            if (next.tv_nsec >= 1000000000) {
+                next.tv_nsec -= 1000000000;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastPrint = start;
+    while (running.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto now = std::chrono::steady_clock::now();
+        double t = std::chrono::duration<double>(now - start).count();
+        // slow steering sweep so the setpoints change
+        sumd.setChannel(STEERING_CHANNEL, (uint16_t)(SUMD_SIM_CENTER + (SUMD_SIM_HIGH - SUMD_SIM_CENTER) * sin(t)));
+
+        if (now - lastPrint >= std::chrono::seconds(1)) {
+            lastPrint = now;
+            SumdSimStats s = sumd.stats();
+            VescSimStats v = vesc.stats();
+            VescSimValues m = vesc.values();
+            printf("sumd frames %lu corrupted %lu noise %lu dropped %lu | vesc duty %lu (%.3f) servo %lu (%.3f) requests %lu crc errors %lu\n",
+                   (unsigned long)s.frames, (unsigned long)s.corrupted, (unsigned long)s.noiseBytes, (unsigned long)s.dropped,
+                   (unsigned long)v.dutyCommands, v.lastDuty, (unsigned long)v.servoCommands, v.lastServo,
+                   (unsigned long)v.valueRequests, (unsigned long)v.crcErrors);
+            printf("model t %.1f s | erpm %d voltage %.2f V current %.1f A fet %.1f C motor %.1f C tacho %d\n",
+                   vesc.modelTime(), m.rpm, m.voltage, m.motorCurrent, m.mosfetTemp, m.motorTemp, m.tachometer);
+            fflush(stdout);
+        }
+        if (duration > 0 && t >= duration) {
+            break;
+        }
+    }
+    running = false;
+    model.join();
+    sumd.stop();
+    vesc.stop();
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "motor_model.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+MotorModel::MotorModel(const MotorParams& params) : p_(params) {
+    ke_ = 60.0 / (2.0 * M_PI * p_.kv);
+    charge_ = p_.initialCharge;
+    voltage_ = openCircuitVoltage();
+    fetTemp_ = p_.ambientTemp;
+    motorTemp_ = p_.ambientTemp;
+}
+
+void MotorModel::setDuty(double duty) {
+    dutyTarget_ = std::clamp(duty, -1.0, 1.0);
+}
+
+void MotorModel::step(double dt) {
+    while (dt > 0.0) {
+        double h = std::min(dt, MOTOR_MODEL_MAX_STEP);
+        integrate(h);
+        dt -= h;
+    }
+}
+
+/// rough LiPo discharge curve per cell: 4.2 V full, 3.7 V at 20 %, then dropping fast to 3.3 V
+double MotorModel::openCircuitVoltage() const {
+    double soc = std::clamp(charge_, 0.0, 1.0);
+    double cell = soc > 0.2 ? 3.7 + (soc - 0.2) / 0.8 * 0.5 : 3.3 + soc / 0.2 * 0.4;
+    return p_.cells * cell;
+}
+
+void MotorModel::integrate(double dt) {
+    // duty ramping of the VESC
+    double maxChange = p_.dutyRamp * dt;
+    duty_ += std::clamp(dutyTarget_ - duty_, -maxChange, maxChange);
+
+    // current limit derated with the mosfet temperature
+    double derate = 1.0;
+    if (fetTemp_ > p_.derateStart) {
+        derate = std::max(0.0, 1.0 - (fetTemp_ - p_.derateStart) / (p_.derateEnd - p_.derateStart));
+    }
+    double currentMax = p_.currentMax * derate;
+
+    // electrical: battery sags with the input current of the last step
+    double ocv = openCircuitVoltage();
+    voltage_ = ocv - inputCurrent_ * p_.batteryResistance;
+    double backEmf = ke_ * omega_;
+    current_ = std::clamp((duty_ * voltage_ - backEmf) / p_.resistance, -currentMax, currentMax);
+    inputCurrent_ = duty_ * current_;
+
+    // mechanical
+    double friction = p_.viscousFriction * omega_;
+    if (omega_ > 0.0) {
+        friction += p_.loadTorque;
+    } else if (omega_ < 0.0) {
+        friction -= p_.loadTorque;
+    }
+    double torque = ke_ * current_;
+    double omega = omega_ + (torque - friction) / p_.inertia * dt;
+    // friction can stop the motor, but not turn it around
+    if (fabs(torque) < p_.loadTorque && omega * omega_ < 0.0) {
+        omega = 0.0;
+    }
+    omega_ = omega;
+
+    // battery
+    charge_ -= inputCurrent_ * dt / (p_.capacity * 3600.0);
+
+    // thermal
+    double motorLoss = current_ * current_ * p_.resistance;
+    double fetLoss = current_ * current_ * p_.fetResistance;
+    motorTemp_ += (motorLoss - (motorTemp_ - p_.ambientTemp) / p_.motorThermalResistance) / p_.motorThermalCapacity * dt;
+    fetTemp_ += (fetLoss - (fetTemp_ - p_.ambientTemp) / p_.fetThermalResistance) / p_.fetThermalCapacity * dt;
+
+    // the tachometer counts commutations, 6 per electrical revolution
+    double commutations = omega_ / (2.0 * M_PI) * p_.polePairs * 6.0 * dt;
+    tacho_ += commutations;
+    tachoAbs_ += fabs(commutations);
+
+    time_ += dt;
+}
+
+VescSimValues MotorModel::values() const {
+    VescSimValues v;
+    v.mosfetTemp = (float)fetTemp_;
+    v.motorTemp = (float)motorTemp_;
+    v.motorCurrent = (float)current_;
+    v.inputCurrent = (float)inputCurrent_;
+    v.dutyCycle = (float)duty_;
+    // the VESC reports electrical rpm
+    v.rpm = (int32_t)(omega_ * 60.0 / (2.0 * M_PI) * p_.polePairs);
+    v.voltage = (float)voltage_;
+    v.tachometer = (int32_t)tacho_;
+    v.tachometerAbs = (int32_t)tachoAbs_;
+    return v;
+}
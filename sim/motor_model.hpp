@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vesc_sim.hpp"
+
+/// parameters of a 1/10 car with a sensorless brushless motor on a 2S LiPo
+struct MotorParams {
+    // motor
+    double kv = 3500.0; // rpm / V
+    double resistance = 0.02; // ohm, phase to phase
+    int polePairs = 2;
+    double currentMax = 60.0; // A, motor current limit of the VESC
+    /// duty cycle change per second the VESC allows (ramping)
+    double dutyRamp = 10.0;
+
+    // drive train, reflected to the motor shaft
+    double inertia = 1e-4; // kg m^2
+    double viscousFriction = 1e-5; // Nm / (rad/s)
+    double loadTorque = 0.01; // Nm, rolling resistance
+
+    // battery
+    int cells = 2;
+    double capacity = 5.0; // Ah
+    double batteryResistance = 0.02; // ohm
+    double initialCharge = 1.0; // 0.0 - 1.0
+
+    // thermal
+    double ambientTemp = 25.0; // C
+    double fetResistance = 0.002; // ohm
+    double fetThermalResistance = 10.0; // K / W to ambient
+    double fetThermalCapacity = 10.0; // J / K
+    double motorThermalResistance = 5.0; // K / W to ambient
+    double motorThermalCapacity = 50.0; // J / K
+    /// current limit is reduced linearly from derateStart to derateEnd (mosfet temperature), like the VESC does
+    double derateStart = 85.0; // C
+    double derateEnd = 100.0; // C
+};
+
+/// longest integration step in seconds
+#define MOTOR_MODEL_MAX_STEP 0.0005
+
+/**
+ * Lumped DC motor, battery and thermal model. Electrical dynamics are ignored (the inductance time constant is far
+ * below the step), so the current follows from duty, battery voltage and back emf. The rest is integrated with
+ * forward Euler steps of at most MOTOR_MODEL_MAX_STEP seconds.
+ */
+class MotorModel {
+public:
+    explicit MotorModel(const MotorParams& params = MotorParams());
+
+    /// duty cycle command as received with COMM_SET_DUTY, in range [-1.0 , 1.0]
+    void setDuty(double duty);
+
+    /// advances the model by dt seconds of simulated time
+    void step(double dt);
+
+    /// current state in the units of COMM_GET_VALUES_SELECTIVE
+    VescSimValues values() const;
+
+    /// simulated seconds since start
+    double time() const { return time_; }
+
+private:
+    void integrate(double dt);
+    double openCircuitVoltage() const;
+
+    MotorParams p_;
+    double ke_; // V / (rad/s), also the torque constant in Nm / A
+
+    double dutyTarget_ = 0.0;
+    double duty_ = 0.0;
+    double omega_ = 0.0; // rad/s, mechanical
+    double current_ = 0.0; // A, motor
+    double inputCurrent_ = 0.0; // A, battery
+    double voltage_;
+    double charge_;
+    double fetTemp_;
+    double motorTemp_;
+    double tacho_ = 0.0;
+    double tachoAbs_ = 0.0;
+    double time_ = 0.0;
+};
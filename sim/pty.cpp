@@ -0,0 +1,32 @@
+#include "pty.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+Pty::Pty() {
+    fd_ = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0 || grantpt(fd_) != 0 || unlockpt(fd_) != 0) {
+        printf("Pty: could not create pseudo terminal. Terminating.\n");
+        exit(1);
+    }
+    path_ = ptsname(fd_);
+
+    slaveFd_ = open(path_.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slaveFd_ < 0) {
+        printf("Pty: could not open %s. Terminating.\n", path_.c_str());
+        exit(1);
+    }
+    // raw mode on the slave side: no echo, no line editing, no newline translation
+    termios tio;
+    tcgetattr(slaveFd_, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slaveFd_, TCSANOW, &tio);
+}
+
+Pty::~Pty() {
+    close(slaveFd_);
+    close(fd_);
+}
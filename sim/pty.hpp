@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Pseudo terminal pair. The simulator keeps the master side, the drivehub opens path() like a real serial port.
+ * The master is non blocking and in raw mode, so bytes pass through unchanged.
+ */
+class Pty {
+public:
+    Pty();
+    ~Pty();
+    Pty(const Pty&) = delete;
+    Pty& operator=(const Pty&) = delete;
+
+    /// master side
+    int fd() const { return fd_; }
+    /// path of the slave side, e.g. /dev/pts/3
+    const std::string& path() const { return path_; }
+
+private:
+    int fd_;
+    /// slave stays open so the master does not see a hangup while the drivehub (re)opens the port
+    int slaveFd_;
+    std::string path_;
+};
@@ -0,0 +1,117 @@
+#include "sumd_sim.hpp"
+#include "crc.h"
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NSEC_PER_SEC 1000000000LL
+
+SumdSimulator::SumdSimulator(int fd) : fd_(fd), rng_(0x5eed) {
+    for (auto& channel : channels_) {
+        channel.store(SUMD_SIM_CENTER, std::memory_order_relaxed);
+    }
+}
+
+SumdSimulator::~SumdSimulator() {
+    stop();
+}
+
+void SumdSimulator::start(int rate, double noise) {
+    if (rate <= 0 || active_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread(&SumdSimulator::run, this, NSEC_PER_SEC / rate, noise);
+}
+
+void SumdSimulator::stop() {
+    active_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SumdSimulator::setChannel(int channel, uint16_t value) {
+    if (channel >= 0 && channel < SUMD_SIM_CHANNELS) {
+        channels_[channel].store(value, std::memory_order_relaxed);
+    }
+}
+
+void SumdSimulator::setFailsafe(bool failsafe) {
+    failsafe_.store(failsafe, std::memory_order_relaxed);
+}
+
+SumdSimStats SumdSimulator::stats() const {
+    SumdSimStats s;
+    s.frames = frames_.load(std::memory_order_relaxed);
+    s.corrupted = corrupted_.load(std::memory_order_relaxed);
+    s.noiseBytes = noiseBytes_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    return s;
+}
+
+/// header, status, channel count, channels and crc, all big endian
+size_t SumdSimulator::encode(uint8_t* out) {
+    size_t len = 0;
+    out[len++] = MAN_ID;
+    out[len++] = failsafe_.load(std::memory_order_relaxed) ? STATE_FS : STATE_NORMAL;
+    out[len++] = SUMD_SIM_CHANNELS;
+    for (auto& channel : channels_) {
+        uint16_t value = channel.load(std::memory_order_relaxed);
+        out[len++] = value >> 8;
+        out[len++] = value & 0xFF;
+    }
+    uint16_t crc = crc16(ByteSpan(out, len));
+    out[len++] = crc >> 8;
+    out[len++] = crc & 0xFF;
+    return len;
+}
+
+void SumdSimulator::writeAll(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd_, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            // EAGAIN: the pty buffer is full since nobody reads the other side
+            dropped_.fetch_add(len, std::memory_order_relaxed);
+            return;
+        }
+        data += written;
+        len -= written;
+    }
+}
+
+void SumdSimulator::run(int64_t periodNs, double noise) {
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::uniform_int_distribution<int> byte(0, 255);
+    uint8_t frame[3 + 2 * SUMD_SIM_CHANNELS + 2];
+    uint8_t garbage[8];
+
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (active_.load()) {
+        size_t len = encode(frame);
+        if (noise > 0.0 && chance(rng_) < noise) {
+            if (chance(rng_) < 0.5) {
+                size_t count = 1 + byte(rng_) % sizeof(garbage);
+                for (size_t i = 0; i < count; i++) {
+                    garbage[i] = (uint8_t)byte(rng_);
+                }
+                writeAll(garbage, count);
+                noiseBytes_.fetch_add(count, std::memory_order_relaxed);
+            } else {
+                frame[byte(rng_) % len] ^= (uint8_t)(1 + byte(rng_) % 255);
+                corrupted_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        writeAll(frame, len);
+        frames_.fetch_add(1, std::memory_order_relaxed);
+
+        next.tv_nsec += periodNs;
+        while (next.tv_nsec >= NSEC_PER_SEC) {
+            next.tv_nsec -= NSEC_PER_SEC;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) == EINTR) {}
+    }
+}
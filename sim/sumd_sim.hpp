@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+
+#include "sumd_parser.hpp"
+
+/// number of channels in the simulated frames
+#define SUMD_SIM_CHANNELS 8
+/// raw channel values, 8 * us. Same scale as SumD_Packet::channel
+#define SUMD_SIM_LOW 8800
+#define SUMD_SIM_CENTER 12000
+#define SUMD_SIM_HIGH 15200
+
+struct SumdSimStats {
+    uint64_t frames = 0;
+    /// frames with a flipped byte
+    uint64_t corrupted = 0;
+    /// random bytes written between frames
+    uint64_t noiseBytes = 0;
+    /// bytes the pty did not take because nobody read them
+    uint64_t dropped = 0;
+};
+
+/**
+ * Streams SUMD frames into a file descriptor at a fixed rate, like the Graupner receiver does.
+ * Noise can be injected: with the given probability per frame either garbage bytes are written in
+ * front of it or one byte of it is flipped, so the crc fails.
+ */
+class SumdSimulator {
+public:
+    explicit SumdSimulator(int fd);
+    ~SumdSimulator();
+
+    /**
+     * @param rate - frames per second
+     * @param noise - probability in [0.0 , 1.0] that a frame is disturbed
+     **/
+    void start(int rate, double noise = 0.0);
+    void stop();
+
+    /// sets a raw channel value (SUMD_SIM_LOW ... SUMD_SIM_HIGH). Can be called while running
+    void setChannel(int channel, uint16_t value);
+    /// sends failsafe frames (status 0x81) instead of normal ones
+    void setFailsafe(bool failsafe);
+
+    SumdSimStats stats() const;
+
+private:
+    void run(int64_t periodNs, double noise);
+    size_t encode(uint8_t* out);
+    void writeAll(const uint8_t* data, size_t len);
+
+    int fd_;
+    std::atomic<uint16_t> channels_[SUMD_SIM_CHANNELS];
+    std::atomic<bool> failsafe_{false};
+    std::mt19937 rng_;
+    std::thread thread_;
+    std::atomic<bool> active_{false};
+
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> corrupted_{0};
+    std::atomic<uint64_t> noiseBytes_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
@@ -0,0 +1,183 @@
+#include "vesc_sim.hpp"
+#include "vesc_commands.hpp"
+#include "motor_model.hpp"
+#include "clock.hpp"
+
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+static int32_t readI32(ByteSpan payload, size_t idx) {
+    return (int32_t)((uint32_t)payload[idx] << 24 | (uint32_t)payload[idx + 1] << 16 |
+                     (uint32_t)payload[idx + 2] << 8 | (uint32_t)payload[idx + 3]);
+}
+
+static int16_t readI16(ByteSpan payload, size_t idx) {
+    return (int16_t)(payload[idx] << 8 | payload[idx + 1]);
+}
+
+static void appendI16(uint8_t* out, size_t& len, int16_t value) {
+    out[len++] = (uint8_t)(value >> 8);
+    out[len++] = (uint8_t)value;
+}
+
+static void appendI32(uint8_t* out, size_t& len, int32_t value) {
+    out[len++] = (uint8_t)(value >> 24);
+    out[len++] = (uint8_t)(value >> 16);
+    out[len++] = (uint8_t)(value >> 8);
+    out[len++] = (uint8_t)value;
+}
+
+VescSimulator::VescSimulator(int fd) : fd_(fd) {}
+
+VescSimulator::~VescSimulator() {
+    stop();
+}
+
+void VescSimulator::start() {
+    if (active_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread(&VescSimulator::run, this);
+}
+
+void VescSimulator::stop() {
+    active_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void VescSimulator::setValues(const VescSimValues& values) {
+    std::lock_guard<std::mutex> lock(m_);
+    values_ = values;
+}
+
+VescSimValues VescSimulator::values() {
+    std::lock_guard<std::mutex> lock(m_);
+    return values_;
+}
+
+void VescSimulator::setModel(std::unique_ptr<MotorModel> model) {
+    std::lock_guard<std::mutex> lock(m_);
+    model_ = std::move(model);
+    if (model_) {
+        values_ = model_->values();
+    }
+}
+
+void VescSimulator::advance(double dt) {
+    std::lock_guard<std::mutex> lock(m_);
+    if (model_) {
+        model_->step(dt);
+        values_ = model_->values();
+    }
+}
+
+double VescSimulator::modelTime() {
+    std::lock_guard<std::mutex> lock(m_);
+    return model_ ? model_->time() : 0.0;
+}
+
+VescSimStats VescSimulator::stats() {
+    std::lock_guard<std::mutex> lock(m_);
+    stats_.crcErrors = decoder_.crcErrors();
+    return stats_;
+}
+
+void VescSimulator::run() {
+    uint8_t buf[256];
+    pollfd pfd{fd_, POLLIN, 0};
+    while (active_.load()) {
+        // short timeout so stop() does not hang
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t len = read(fd_, buf, sizeof(buf));
+        if (len <= 0) {
+            if (len < 0 && errno != EAGAIN && errno != EINTR) {
+                // EIO: nobody has the slave side open right now
+                usleep(10000);
+            }
+            continue;
+        }
+        decoder_.write(ByteSpan(buf, (size_t)len));
+        ByteSpan payload;
+        while (decoder_.next(payload)) {
+            handlePayload(payload);
+        }
+    }
+}
+
+void VescSimulator::handlePayload(ByteSpan payload) {
+    std::lock_guard<std::mutex> lock(m_);
+    switch (payload[0]) {
+    case COMM_SET_DUTY:
+        if (payload.size() >= 5) {
+            stats_.lastDuty = readI32(payload, 1) / 100000.0f;
+            stats_.lastDutyNs = monotonicNs();
+            stats_.dutyCommands++;
+            if (model_) {
+                model_->setDuty(stats_.lastDuty);
+            } else {
+                values_.dutyCycle = stats_.lastDuty;
+            }
+        }
+        break;
+    case COMM_SET_SERVO_POS:
+        if (payload.size() >= 3) {
+            stats_.lastServo = readI16(payload, 1) / 1000.0f;
+            stats_.lastServoNs = monotonicNs();
+            stats_.servoCommands++;
+        }
+        break;
+    case COMM_GET_VALUES_SELECTIVE:
+        if (payload.size() >= 5) {
+            stats_.valueRequests++;
+            answerValuesSelective((uint32_t)readI32(payload, 1));
+        }
+        break;
+    default:
+        stats_.otherCommands++;
+        break;
+    }
+}
+
+/// field order and scales as in the VESC firmware (commands.c). Called with m_ held
+void VescSimulator::answerValuesSelective(uint32_t mask) {
+    const VescSimValues& v = values_;
+    uint8_t payload[64];
+    size_t len = 0;
+    payload[len++] = COMM_GET_VALUES_SELECTIVE;
+    appendI32(payload, len, (int32_t)mask);
+    if (mask & (1 << 0)) appendI16(payload, len, (int16_t)(v.mosfetTemp * 10));
+    if (mask & (1 << 1)) appendI16(payload, len, (int16_t)(v.motorTemp * 10));
+    if (mask & (1 << 2)) appendI32(payload, len, (int32_t)(v.motorCurrent * 100));
+    if (mask & (1 << 3)) appendI32(payload, len, (int32_t)(v.inputCurrent * 100));
+    if (mask & (1 << 4)) appendI32(payload, len, 0); // id
+    if (mask & (1 << 5)) appendI32(payload, len, 0); // iq
+    if (mask & (1 << 6)) appendI16(payload, len, (int16_t)(v.dutyCycle * 1000));
+    if (mask & (1 << 7)) appendI32(payload, len, v.rpm);
+    if (mask & (1 << 8)) appendI16(payload, len, (int16_t)(v.voltage * 10));
+    if (mask & (1 << 9)) appendI32(payload, len, 0); // amp hours
+    if (mask & (1 << 10)) appendI32(payload, len, 0); // amp hours charged
+    if (mask & (1 << 11)) appendI32(payload, len, 0); // watt hours
+    if (mask & (1 << 12)) appendI32(payload, len, 0); // watt hours charged
+    if (mask & (1 << 13)) appendI32(payload, len, v.tachometer);
+    if (mask & (1 << 14)) appendI32(payload, len, v.tachometerAbs);
+    if (mask & (1 << 15)) payload[len++] = v.fault;
+
+    uint8_t frame[sizeof(payload) + VESC_FRAME_OVERHEAD_MAX];
+    size_t frameLen = vescEncodeFrame(ByteSpan(payload, len), MutableByteSpan(frame, sizeof(frame)));
+    const uint8_t* data = frame;
+    while (frameLen > 0) {
+        ssize_t written = write(fd_, data, frameLen);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return; // nobody reads the answer
+        }
+        data += written;
+        frameLen -= written;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "vesc_frame.hpp"
+
+/// values reported on COMM_GET_VALUES_SELECTIVE, in the units of the VESC firmware
+struct VescSimValues {
+    float mosfetTemp = 25.0;
+    float motorTemp = 25.0;
+    float motorCurrent = 0.0;
+    float inputCurrent = 0.0;
+    float dutyCycle = 0.0;
+    int32_t rpm = 0;
+    float voltage = 8.4;
+    int32_t tachometer = 0;
+    int32_t tachometerAbs = 0;
+    uint8_t fault = 0;
+};
+
+class MotorModel;
+
+struct VescSimStats {
+    uint64_t dutyCommands = 0;
+    uint64_t servoCommands = 0;
+    uint64_t valueRequests = 0;
+    uint64_t otherCommands = 0;
+    uint64_t crcErrors = 0;
+    /// last received setpoints, as sent on the wire
+    float lastDuty = 0.0;
+    float lastServo = 0.0;
+    int64_t lastDutyNs = 0;
+    int64_t lastServoNs = 0;
+};
+
+/**
+ * Emulates the VESC on the other side of a file descriptor. Decodes the frames the drivehub sends,
+ * records COMM_SET_DUTY and COMM_SET_SERVO_POS and answers COMM_GET_VALUES_SELECTIVE with the fields of
+ * the requested mask taken from values(). With a MotorModel attached, the duty commands drive the model
+ * and the answers report its state.
+ */
+class VescSimulator {
+public:
+    explicit VescSimulator(int fd);
+    ~VescSimulator();
+
+    void start();
+    void stop();
+
+    /// values used for the next answer. Can be changed while running
+    void setValues(const VescSimValues& values);
+    VescSimValues values();
+
+    /// lets the duty commands drive a motor model instead of reporting fixed values
+    void setModel(std::unique_ptr<MotorModel> model);
+    /// advances the model by dt seconds of simulated time. Does nothing without a model
+    void advance(double dt);
+    /// simulated seconds of the model
+    double modelTime();
+
+    VescSimStats stats();
+
+private:
+    void run();
+    void handlePayload(ByteSpan payload);
+    void answerValuesSelective(uint32_t mask);
+
+    int fd_;
+    VescFrameDecoder decoder_;
+    std::mutex m_;
+    VescSimValues values_;
+    std::unique_ptr<MotorModel> model_;
+    VescSimStats stats_;
+    std::thread thread_;
+    std::atomic<bool> active_{false};
+};
@@ -0,0 +1,102 @@
+#include "control_loop.hpp"
+#include "log.hpp"
+#include "clock.hpp"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/prctl.h>
+#include <time.h>
+
+#define NSEC_PER_SEC 1000000000LL
+
+static inline timespec fromNs(int64_t ns) {
+    timespec ts;
+    ts.tv_sec = ns / NSEC_PER_SEC;
+    ts.tv_nsec = ns % NSEC_PER_SEC;
+    return ts;
+}
+
+ControlLoop::ControlLoop(std::function<void(void)> tick) : tick_(tick) {}
+
+ControlLoop::~ControlLoop() {
+    stop();
+}
+
+void ControlLoop::start(int rate, int priority, int cpu) {
+    if (rate <= 0 || active_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread(&ControlLoop::run, this, NSEC_PER_SEC / rate);
+
+    if (priority > 0) {
+        sched_param param{};
+        param.sched_priority = priority;
+        if (pthread_setschedparam(thread_.native_handle(), SCHED_FIFO, &param) != 0) {
+            LOG_WARN(core, "ControlLoop: could not switch to SCHED_FIFO (missing CAP_SYS_NICE?)");
+        }
+    }
+    if (cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        if (pthread_setaffinity_np(thread_.native_handle(), sizeof(cpu_set_t), &cpuset) != 0) {
+            LOG_WARN(core, "ControlLoop: could not pin thread to cpu %d", cpu);
+        }
+    }
+}
+
+void ControlLoop::stop() {
+    active_ = false;
+    if (thread_.joinable() && std::this_thread::get_id() != thread_.get_id()) {
+        thread_.join();
+    }
+}
+
+ControlLoopStats ControlLoop::stats() const {
+    ControlLoopStats s;
+    s.ticks = ticks_.load(std::memory_order_relaxed);
+    s.overruns = overruns_.load(std::memory_order_relaxed);
+    s.lastJitterNs = lastJitterNs_.load(std::memory_order_relaxed);
+    s.maxJitterNs = maxJitterNs_.load(std::memory_order_relaxed);
+    s.meanJitterNs = s.ticks > 0 ? sumJitterNs_.load(std::memory_order_relaxed) / (int64_t)s.ticks : 0;
+    s.maxTickNs = maxTickNs_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void ControlLoop::run(int64_t periodNs) {
+    // default timer slack of SCHED_OTHER threads is 50 us, which would show up as jitter
+    prctl(PR_SET_TIMERSLACK, 1);
+    int64_t deadline = monotonicNs() + periodNs;
+    while (active_.load()) {
+        timespec ts = fromNs(deadline);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+        if (!active_.load()) {
+            return;
+        }
+
+        int64_t start = monotonicNs();
+        int64_t jitter = start - deadline;
+        tick_();
+        int64_t end = monotonicNs();
+
+        // only this thread writes, so load + store is enough
+        ticks_.store(ticks_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        lastJitterNs_.store(jitter, std::memory_order_relaxed);
+        sumJitterNs_.store(sumJitterNs_.load(std::memory_order_relaxed) + jitter, std::memory_order_relaxed);
+        if (jitter > maxJitterNs_.load(std::memory_order_relaxed)) {
+            maxJitterNs_.store(jitter, std::memory_order_relaxed);
+        }
+        if (end - start > maxTickNs_.load(std::memory_order_relaxed)) {
+            maxTickNs_.store(end - start, std::memory_order_relaxed);
+        }
+
+        deadline += periodNs;
+        if (end > deadline) {
+            // overrun: skip the periods we missed instead of firing a burst of ticks
+            overruns_.store(overruns_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            deadline += ((end - deadline) / periodNs + 1) * periodNs;
+        }
+    }
+}
@@ -1,10 +1,143 @@
 #include "crc.h"
 
-unsigned short crc16(unsigned char *buf, unsigned int len) {
-	unsigned int i;
-	unsigned short cksum = 0;
-	for (i = 0; i < len; i++) {
-		cksum = crc16_tab[(((cksum >> 8) ^ *buf++) & 0xFF)] ^ (cksum << 8);
-	}
-	return cksum;
-}
\ No newline at end of file
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC16_HAVE_CLMUL 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define CRC16_HAVE_CLMUL 1
+#endif
+
+/// below this length the setup of the folding kernel does not pay off
+#define CRC16_CLMUL_MINLEN 64
+
+// x^n mod P, used as folding constants
+static constexpr uint64_t xPowMod(int n) {
+    uint32_t r = 1;
+    for (int i = 0; i < n; i++) {
+        r <<= 1;
+        if (r & 0x10000) {
+            r ^= 0x10000 | CRC16_POLY;
+        }
+    }
+    return r;
+}
+
+uint16_t crc16Bytewise(uint16_t crc, ByteSpan data) {
+    for (uint8_t byte : data) {
+        crc = crc16Update(crc, byte);
+    }
+    return crc;
+}
+
+uint16_t crc16Slicing8(uint16_t crc, ByteSpan data) {
+    const uint8_t* p = data.data();
+    size_t len = data.size();
+    const auto& t = crc16_tables;
+    while (len >= 8) {
+        // the crc register is xored into the first two bytes, then each byte is advanced by its distance to the end
+        crc = t[7][p[0] ^ (crc >> 8)] ^ t[6][p[1] ^ (crc & 0xFF)] ^ t[5][p[2]] ^ t[4][p[3]] ^
+              t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+        p += 8;
+        len -= 8;
+    }
+    return crc16Bytewise(crc, ByteSpan(p, len));
+}
+
+/*
+ * Folding: 16 byte blocks are read as 128 bit polynomials (first byte highest). Appending a block B to the
+ * remainder X gives X*x^128 + B, which is congruent to X_hi*(x^192 mod P) + X_lo*(x^128 mod P) + B.
+ * The products of a 64 bit half with a 16 bit constant fit into 128 bits again. The final 128 bit
+ * remainder is reduced with the table kernel.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("pclmul,ssse3")))
+static uint16_t foldBlocks(uint16_t crc, const uint8_t* p, size_t blocks) {
+    const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i k = _mm_set_epi64x((int64_t)xPowMod(128), (int64_t)xPowMod(192));
+    __m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)p), bswap);
+    x = _mm_xor_si128(x, _mm_set_epi64x((int64_t)((uint64_t)crc << 48), 0));
+    for (size_t i = 1; i < blocks; i++) {
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16 * i)), bswap);
+        __m128i hi = _mm_clmulepi64_si128(x, k, 0x01); // X_hi * x^192
+        __m128i lo = _mm_clmulepi64_si128(x, k, 0x10); // X_lo * x^128
+        x = _mm_xor_si128(_mm_xor_si128(hi, lo), b);
+    }
+    uint8_t rem[16];
+    _mm_storeu_si128((__m128i*)rem, _mm_shuffle_epi8(x, bswap));
+    return crc16Slicing8(0, ByteSpan(rem, 16));
+}
+
+bool crc16ClmulSupported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+}
+
+#elif defined(__aarch64__)
+
+static inline uint64_t loadBE64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return __builtin_bswap64(v);
+}
+
+static inline void storeBE64(uint8_t* p, uint64_t v) {
+    v = __builtin_bswap64(v);
+    memcpy(p, &v, 8);
+}
+
+__attribute__((target("+crypto")))
+static uint16_t foldBlocks(uint16_t crc, const uint8_t* p, size_t blocks) {
+    const poly64_t k192 = (poly64_t)xPowMod(192);
+    const poly64_t k128 = (poly64_t)xPowMod(128);
+    uint64_t hi = loadBE64(p) ^ ((uint64_t)crc << 48);
+    uint64_t lo = loadBE64(p + 8);
+    for (size_t i = 1; i < blocks; i++) {
+        uint64x2_t x = veorq_u64(vreinterpretq_u64_p128(vmull_p64((poly64_t)hi, k192)),
+                                 vreinterpretq_u64_p128(vmull_p64((poly64_t)lo, k128)));
+        hi = vgetq_lane_u64(x, 1) ^ loadBE64(p + 16 * i);
+        lo = vgetq_lane_u64(x, 0) ^ loadBE64(p + 16 * i + 8);
+    }
+    uint8_t rem[16];
+    storeBE64(rem, hi);
+    storeBE64(rem + 8, lo);
+    return crc16Slicing8(0, ByteSpan(rem, 16));
+}
+
+bool crc16ClmulSupported() {
+    return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+}
+
+#else
+
+bool crc16ClmulSupported() {
+    return false;
+}
+
+#endif
+
+uint16_t crc16Clmul(uint16_t crc, ByteSpan data) {
+#ifdef CRC16_HAVE_CLMUL
+    size_t blocks = data.size() / 16;
+    if (blocks > 0) {
+        crc = foldBlocks(crc, data.data(), blocks);
+    }
+    return crc16Slicing8(crc, data.subspan(blocks * 16));
+#else
+    return crc16Slicing8(crc, data);
+#endif
+}
+
+static const bool clmulAvailable = crc16ClmulSupported();
+
+uint16_t crc16Update(uint16_t crc, ByteSpan data) {
+    if (clmulAvailable && data.size() >= CRC16_CLMUL_MINLEN) {
+        return crc16Clmul(crc, data);
+    }
+    return crc16Slicing8(crc, data);
+}
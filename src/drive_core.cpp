@@ -0,0 +1,85 @@
+#include "drive_core.hpp"
+#include "config.h"
+
+DriveCore::DriveCore(Context& context, Clock now) : context_(context), now_(now) {}
+
+Mailbox<ReceiverPacket>::Clock::time_point DriveCore::timePoint(int64_t ns) const {
+    using Clock = Mailbox<ReceiverPacket>::Clock;
+    return Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+int64_t DriveCore::toNs(Mailbox<ReceiverPacket>::Clock::time_point timePoint) const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint.time_since_epoch()).count();
+}
+
+void DriveCore::receiverInput(const ReceiverPacket& packet) {
+    // age and latency count from the serial read, not from the end of the parser
+    receiverInput_.publish(packet, timePoint(packet.timestampNs > 0 ? packet.timestampNs : now_()));
+}
+
+void DriveCore::driveInput(const control_msg::Drive& msg) {
+    driveInput_.publish(msg, timePoint(now_()));
+}
+
+/// @return true if the input was published since the last call and is not older than INPUT_MAX_AGE
+template<typename Snapshot>
+bool DriveCore::takeFresh(const Snapshot& snapshot, uint64_t& seen, int64_t now) {
+    if (snapshot.seq == seen) {
+        return false;
+    }
+    seen = snapshot.seq;
+    // a stale value would apply an old setpoint. The watchdog takes care of a silent input
+    return snapshot.age(timePoint(now)) <= INPUT_MAX_AGE;
+}
+
+void DriveCore::tick() {
+    int64_t now = now_();
+    auto receiverSnapshot = receiverInput_.read();
+    auto driveSnapshot = driveInput_.read();
+    bool newPacket = takeFresh(receiverSnapshot, receiverInputSeen_, now);
+    bool newDriveMsg = takeFresh(driveSnapshot, driveInputSeen_, now);
+    const ReceiverPacket& packet = receiverSnapshot.value;
+    const control_msg::Drive& msg = driveSnapshot.value;
+
+    std::lock_guard<std::mutex> lock(m_context_);
+    if (newPacket) {
+        context_.updateReceiverPacket(packet);
+        context_.receiverConnected();
+        // send triggers initiated by receiver
+        if (packet.lateral_control) {
+            if (packet.autonomous) {
+                context_.autonomousControl();
+            } else {
+                context_.lateralControl();
+            }
+        } else {
+            context_.manualControl();
+        }
+        if (packet.throttle <= 0.005) {
+            context_.receiverMotorReset();
+        }
+    }
+    if (newDriveMsg) {
+        context_.updateDriveMsg(msg);
+    }
+    context_.emitSetpoint();
+
+    // inputs are only counted in the tick which passes them on
+    int64_t sent = now_();
+    if (newPacket) {
+        receiverLatency_.record(sent - toNs(receiverSnapshot.timestamp));
+    }
+    if (newDriveMsg) {
+        driveLatency_.record(sent - toNs(driveSnapshot.timestamp));
+    }
+}
+
+void DriveCore::receiverTimedOut() {
+    std::lock_guard<std::mutex> lock(m_context_);
+    context_.receiverTimedOut();
+}
+
+void DriveCore::swiftrobotTimedOut() {
+//    std::lock_guard<std::mutex> lock(m_context_);
+//    context_.swiftrobotTimedOut();
+}
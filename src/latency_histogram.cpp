@@ -0,0 +1,51 @@
+#include "latency_histogram.hpp"
+
+#include <stdio.h>
+
+int64_t LatencyHistogram::percentile(double p) const {
+    uint64_t total = total_.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return 0;
+    }
+    // rank of the value at p, at least the first one
+    uint64_t rank = (uint64_t)(p / 100.0 * total + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    int64_t max = max_.load(std::memory_order_relaxed);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            int64_t value = upperBound(i);
+            return value < max ? value : max;
+        }
+    }
+    return max;
+}
+
+LatencyStats LatencyHistogram::stats() const {
+    LatencyStats stats;
+    stats.count = total_.load(std::memory_order_relaxed);
+    stats.p50 = percentile(50.0);
+    stats.p99 = percentile(99.0);
+    stats.p999 = percentile(99.9);
+    stats.max = max_.load(std::memory_order_relaxed);
+    stats.mean = stats.count > 0 ? (double)sum_.load(std::memory_order_relaxed) / stats.count : 0.0;
+    return stats;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    total_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::print(const char* name) const {
+    LatencyStats s = stats();
+    printf("%-16s n %8llu  p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us  max %8.1f us\n", name,
+           (unsigned long long)s.count, s.p50 / 1e3, s.p99 / 1e3, s.p999 / 1e3, s.max / 1e3);
+}
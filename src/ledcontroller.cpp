@@ -1,4 +1,5 @@
  #include "ledcontroller.hpp"
+ #include "log.hpp"
  
  /**
   * Configures GPIOs which are used for LEDs. Should only be created once
@@ -57,7 +58,7 @@
         lateralCycle(); // first start manual so there is a change right away
         blueMode = lateral;
         lateralTimer->setInterval(std::bind(&LEDController::lateralCycle, this), LATERAL_BLINK_INTERVAL);
-        printf("started lateral\n");
+        LOG_DEBUG(led, "started lateral");
       }
     }
   }
@@ -0,0 +1,194 @@
+#include "log.hpp"
+#include "clock.hpp"
+
+#include <algorithm>
+
+static const char* const levelNames[] = {"off", "error", "warn", "info", "debug", "trace"};
+static const char levelTags[] = {'-', 'E', 'W', 'I', 'D', 'T'};
+static const char* const subsystemNames[] = {"core", "fsm", "receiver", "vesc", "led", "swiftrobot", "recorder", "metrics"};
+static_assert(sizeof(subsystemNames) / sizeof(subsystemNames[0]) == (size_t)LogSubsystem::count, "every subsystem needs a name");
+
+std::atomic<uint8_t> Logger::levels_[(size_t)LogSubsystem::count] = {
+    {(uint8_t)LogLevel::info}, {(uint8_t)LogLevel::info}, {(uint8_t)LogLevel::info}, {(uint8_t)LogLevel::info},
+    {(uint8_t)LogLevel::info}, {(uint8_t)LogLevel::info}, {(uint8_t)LogLevel::info}, {(uint8_t)LogLevel::info},
+};
+
+Logger& Logger::global() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+void Logger::setLevel(LogSubsystem subsystem, LogLevel level) {
+    levels_[(size_t)subsystem].store((uint8_t)level, std::memory_order_relaxed);
+}
+
+LogLevel Logger::level(LogSubsystem subsystem) {
+    return (LogLevel)levels_[(size_t)subsystem].load(std::memory_order_relaxed);
+}
+
+static bool parseLevel(const std::string& name, LogLevel& level) {
+    for (size_t i = 0; i < sizeof(levelNames) / sizeof(levelNames[0]); i++) {
+        if (name == levelNames[i]) {
+            level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Logger::setLevels(const std::string& spec) {
+    bool ok = true;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        std::string part = spec.substr(start, end - start);
+        start = end + 1;
+        if (part.empty()) {
+            continue;
+        }
+        LogLevel level;
+        size_t eq = part.find('=');
+        if (eq == std::string::npos) {
+            if (!parseLevel(part, level)) {
+                ok = false;
+                continue;
+            }
+            for (size_t i = 0; i < (size_t)LogSubsystem::count; i++) {
+                setLevel((LogSubsystem)i, level);
+            }
+            continue;
+        }
+        std::string name = part.substr(0, eq);
+        auto it = std::find_if(std::begin(subsystemNames), std::end(subsystemNames),
+                               [&](const char* s) { return name == s; });
+        if (it == std::end(subsystemNames) || !parseLevel(part.substr(eq + 1), level)) {
+            ok = false;
+            continue;
+        }
+        setLevel((LogSubsystem)(it - std::begin(subsystemNames)), level);
+    }
+    return ok;
+}
+
+Logger::ThreadRing& Logger::threadRing() {
+    // the global logger lives until exit and never frees a ring, so the cached pointer stays valid
+    thread_local ThreadRing* ring = nullptr;
+    if (!ring) {
+        std::lock_guard<std::mutex> lock(m_);
+        rings_.push_back(std::make_unique<ThreadRing>());
+        ring = rings_.back().get();
+    }
+    return *ring;
+}
+
+void Logger::commit(const LogSite& site, uint8_t* record, size_t len) {
+    ThreadRing& tr = threadRing();
+    // all or nothing, so the writer thread never sees half a record
+    if (tr.ring.space() < sizeof(Header) + len) {
+        tr.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Header header;
+    header.site = &site;
+    header.timestampNs = monotonicNs();
+    header.length = (uint16_t)len;
+    memcpy(record, &header, sizeof(header));
+    tr.ring.write(ByteSpan(record, sizeof(header) + len));
+    tr.records.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Logger::dropped() {
+    threadRing().dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Logger::start(FILE* out, std::chrono::milliseconds flushInterval) {
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        out_ = out;
+    }
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread(&Logger::run, this, flushInterval);
+}
+
+void Logger::stop() {
+    if (running_.exchange(false) && thread_.joinable()) {
+        thread_.join();
+    }
+    flush();
+}
+
+void Logger::run(std::chrono::milliseconds flushInterval) {
+    while (running_.load()) {
+        std::this_thread::sleep_for(flushInterval);
+        flush();
+    }
+}
+
+void Logger::flush() {
+    struct Entry {
+        Header header;
+        size_t offset;
+    };
+    std::lock_guard<std::mutex> lock(m_);
+    std::vector<Entry> entries;
+    drainBuffer_.clear();
+    for (auto& tr : rings_) {
+        auto& ring = tr->ring;
+        while (ring.available() >= sizeof(Header)) {
+            Header header;
+            uint8_t* raw = reinterpret_cast<uint8_t*>(&header);
+            for (size_t i = 0; i < sizeof(header); i++) {
+                raw[i] = ring[i];
+            }
+            if (ring.available() < sizeof(header) + header.length) {
+                break; // still being written
+            }
+            ring.pop(sizeof(header));
+            size_t offset = drainBuffer_.size();
+            drainBuffer_.resize(offset + header.length);
+            ring.read(MutableByteSpan(drainBuffer_.data() + offset, header.length));
+            entries.push_back(Entry{header, offset});
+        }
+    }
+    if (entries.empty()) {
+        return;
+    }
+    // every ring is in order by itself, merge them by time
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.header.timestampNs < b.header.timestampNs;
+    });
+    char message[LOG_MAX_LINE];
+    for (const Entry& entry : entries) {
+        const LogSite& site = *entry.header.site;
+        if (site.formatter(site.format, drainBuffer_.data() + entry.offset, message, sizeof(message)) < 0) {
+            snprintf(message, sizeof(message), "(could not format '%s')", site.format);
+        }
+        size_t len = strlen(message);
+        // the format strings come from printf calls, most of them end with a newline
+        if (len > 0 && message[len - 1] == '\n') {
+            message[len - 1] = 0;
+        }
+        fprintf(out_, "%.6f %c %-10s %s\n", entry.header.timestampNs / 1e9, levelTags[(size_t)site.level],
+                subsystemNames[(size_t)site.subsystem], message);
+    }
+    fflush(out_);
+}
+
+LoggerStats Logger::stats() {
+    LoggerStats s;
+    std::lock_guard<std::mutex> lock(m_);
+    for (auto& ring : rings_) {
+        s.records += ring->records.load(std::memory_order_relaxed);
+        s.dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return s;
+}
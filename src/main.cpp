@@ -1,18 +1,29 @@
 #include "config.h"
+#include "reactor.hpp"
 #include "serial.hpp"
 #include "receiver.hpp"
 #include "vesc.hpp"
-#include "timer.hpp"
+#include "vesc_poller.hpp"
 #include "ledcontroller.hpp"
+#include "control_loop.hpp"
+#include "watchdog.hpp"
+#include "drive_core.hpp"
+#include "recorder.hpp"
+#include "metrics.hpp"
+#include "log.hpp"
+#include "status_msgs.hpp"
+#include "publisher.hpp"
+#include "telemetry.hpp"
+#include "clock.hpp"
 
 #include "swiftrobotc/swiftrobotc.h"
 #include "swiftrobotc/msgs.h"
 
 // FSM
-#include "states/base_state.hpp"
-#include "states/setup.hpp"
 #include "context.hpp"
 
+#include <getopt.h>
+#include <signal.h>
 #include <unistd.h>
 #include <condition_variable>
 #include <chrono>
@@ -21,119 +32,270 @@
 
 using namespace std::chrono_literals;
 
-#define DEBUGGING
-#ifdef DEBUGGING
-#define DBG_PRINT(x...) printf(x)
-#else
-#define DBG_PRINT(x...) //
-#endif
-
 // global properties
 std::unique_ptr<Context> context;
+/// inputs -> FSM -> setpoints, stepped by the control loop
+std::unique_ptr<DriveCore> core;
 
+/// runs the callbacks of all serial devices
+std::shared_ptr<Reactor> reactor;
 std::shared_ptr<SwiftRobotClient> swiftrobotclient;
 std::shared_ptr<Vesc> vesc;
 std::shared_ptr<Receiver> receiver;
 std::shared_ptr<LEDController> ledcontroller;
-/// timer in which interval the vesc status is published via swiftrobotm
-std::unique_ptr<Timer> vescStatusPublishTimer; 
+/// requests the vesc state, the answers are published via swiftrobotm
+std::unique_ptr<VescPoller> vescPoller;
+/// steps the FSM and sends the setpoints at a fixed rate
+std::unique_ptr<ControlLoop> controlLoop;
+/// keeps the raw serial traffic, decoded inputs and FSM transitions on disk
+std::unique_ptr<Recorder> recorder;
+/// heartbeat deadlines of receiver and iOS device
+std::unique_ptr<Watchdog> watchdog;
+/// swiftrobot publishing runs on its own thread, so a slow link does not hold up the serial ports
+std::unique_ptr<Publisher> publisher;
+Publisher::Topic<VescData>* statusTopic = nullptr;
+Publisher::Topic<ReceiverPacket>* receiverTopic = nullptr;
+/// only set with --telemetry
+Publisher::Topic<TelemetrySample>* telemetryTopic = nullptr;
+int receiverHeartbeat;
+int swiftrobotHeartbeat;
+/// messages handed to swiftrobot per channel
+Counter& statusPublished = Metrics::global().counter("drivehub_swiftrobot_published_total", "messages published per swiftrobot channel", "channel=\"status\"");
+Counter& receiverPublished = Metrics::global().counter("drivehub_swiftrobot_published_total", "messages published per swiftrobot channel", "channel=\"receiver\"");
+Counter& telemetryPublished = Metrics::global().counter("drivehub_swiftrobot_published_total", "messages published per swiftrobot channel", "channel=\"telemetry\"");
+Counter& telemetryBytes = Metrics::global().counter("drivehub_telemetry_bytes_total", "bytes of telemetry frames", "",
+                                                    "drivehub_telemetry_bytes_per_second");
 
-auto lastSwiftrobotPing = std::chrono::high_resolution_clock::now();
-auto lastReceiverPing = std::chrono::high_resolution_clock::now();
 
-std::mutex m_context;
+/// cleared by SIGINT/SIGTERM
+volatile sig_atomic_t running = 1;
+/// set by SIGUSR1, the main thread prints the latency histograms
+volatile sig_atomic_t dumpLatency = 0;
 
-// helper
-bool timedOut(std::chrono::_V2::system_clock::time_point toCheck, std::chrono::milliseconds timeout) {
-    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - toCheck) > timeout;
-}
+/// one message per published topic, refilled for every publish. Both are only touched on the publisher thread
+base_msg::UInt32Array statusMsg;
+base_msg::UInt16Array receiverMsg;
+/// telemetry frame which is being filled
+base_msg::UInt8Array telemetryMsg;
+TelemetryEncoder telemetryEncoder(TELEMETRY_MAX_SAMPLES);
 
 // *************************
 // callbacks
 // *************************
 
+// publisher thread
+void publishVescStatus(const VescData& data) {
+    vescStatusMsg(data, statusMsg);
+    publishInPlace(*swiftrobotclient, SR_STATUS, statusMsg);
+    statusPublished.add();
+}
+
+void publishReceiverPacket(const ReceiverPacket& packet) {
+    receiverPacketMsg(packet, receiverMsg);
+    publishInPlace(*swiftrobotclient, SR_RECEIVER, receiverMsg);
+    receiverPublished.add();
+}
+
+// publisher thread, every TELEMETRY_FLUSH_INTERVAL and for full frames
+void flushTelemetry() {
+    if (telemetryMsg.data.empty()) {
+        return;
+    }
+    publishInPlace(*swiftrobotclient, SR_TELEMETRY, telemetryMsg);
+    telemetryPublished.add();
+    telemetryBytes.add(telemetryMsg.data.size());
+    telemetryMsg.data.clear();
+}
+
+void addTelemetrySample(const TelemetrySample& sample) {
+    telemetryEncoder.add(sample, telemetryMsg.data);
+    if (telemetryEncoder.full()) {
+        flushTelemetry();
+    }
+}
+
 // callbacks from hardware
 void receivedVescStatus(VescData data) {
-    base_msg::UInt32Array msg;
-    // cast our packet into a uint16_t vector
-    std::vector<uint32_t> ser_vesc;
-    // for float we are using the same scales as VESC (e.g. vesc.cpp->analyzePacket())
-    ser_vesc.push_back((uint32_t)(data.mosfet_temp*10));
-    ser_vesc.push_back((uint32_t)(data.motor_temp*10));
-    ser_vesc.push_back((uint32_t) data.rpm);
-    ser_vesc.push_back((uint32_t) (data.voltage*10));
-    ser_vesc.push_back((uint32_t) data.ticks);
-    ser_vesc.push_back((uint32_t) data.ticksAbs);
-    msg.data = ser_vesc;
-    swiftrobotclient->publish(SR_STATUS, msg);
+    vescPoller->answered(data);
+    if (Recorder* r = Recorder::active()) {
+        r->recordValue(RecordType::vescData, 0, data);
+    }
+    statusTopic->push(data);
+    if (telemetryTopic) {
+        TelemetrySample sample;
+        sample.kind = TelemetryKind::vesc;
+        sample.timestampNs = monotonicNs();
+        sample.vesc = data;
+        telemetryTopic->push(sample);
+    }
 }
 
 void receivedReceiverPacket(ReceiverPacket packet) {
-    lastReceiverPing = std::chrono::high_resolution_clock::now();
-    m_context.lock();
-    context->updateReceiverPacket(packet);
-    context->receiverConnected();
-    // send triggers initiated by receiver
-    if (packet.lateral_control) {
-        if (packet.autonomous) {
-            context->autonomousControl();
-        } else {
-            context->lateralControl();
-        }
-    } else {
-        context->manualControl();
-    }
-    if (packet.throttle <= 0.005) {
-        context->receiverMotorReset();
+    watchdog->feed(receiverHeartbeat);
+    if (Recorder* r = Recorder::active()) {
+        r->recordValue(RecordType::receiverPacket, 0, packet);
     }
-    m_context.unlock();
-
+    core->receiverInput(packet);
 
     // now forward our packet to the iOS Device
-    base_msg::UInt16Array msg;
-    // cast our packet into a uint16_t vector
-    std::vector<uint16_t> ser_packet;
-    ser_packet.push_back((uint16_t)(packet.throttle*65000)); // this maps throttle to 0-65000
-    ser_packet.push_back((uint16_t)(packet.steering*65000)); // this maps steering to 0-65000
-    ser_packet.push_back((uint16_t) packet.gearSelector); // 0 = undefined, 1 = drive, 2 = reverse
-    ser_packet.push_back((uint16_t) packet.lateral_control); // 0 false, 1 true
-    ser_packet.push_back((uint16_t) packet.autonomous); // 0 false, 1 true
-    msg.data = ser_packet;
-    swiftrobotclient->publish(SR_RECEIVER, msg);
+    receiverTopic->push(packet);
+    if (telemetryTopic) {
+        TelemetrySample sample;
+        sample.kind = TelemetryKind::receiver;
+        sample.timestampNs = packet.timestampNs;
+        sample.receiver = packet;
+        telemetryTopic->push(sample);
+    }
 }
 
 // swiftrobotm callbacks 
 void swiftrobotmReceivedInternal(internal_msg::UpdateMsg msg) {
-    DBG_PRINT("Device %d is now %d \n", msg.deviceID, msg.status);
-    m_context.lock();
+    LOG_INFO(swiftrobot, "Device %d is now %d", (int)msg.deviceID, (int)msg.status);
     context->swiftrobotConnected = (msg.status == internal_msg::status_t::CONNECTED);
-    m_context.unlock();
 }
 
 void swiftrobotmReceivedDrive(control_msg::Drive msg) {
-    lastSwiftrobotPing = std::chrono::high_resolution_clock::now();
-     m_context.lock();
-    context->updateDriveMsg(msg);
-     m_context.unlock();
+    watchdog->feed(swiftrobotHeartbeat);
+    if (Recorder* r = Recorder::active()) {
+        r->recordValue(RecordType::driveMsg, 0, msg);
+    }
+    core->driveInput(msg);
 }
 
-// timer callbacks
-void timerTriggeredVescStatusPublish() {
-    // ask for vesc status; response comes async over callback
-    vesc->requestState();
+/// values which are kept by the components themselves
+void registerMetrics() {
+    Metrics& metrics = Metrics::global();
+    metrics.callback(Metrics::Type::counter, "drivehub_watchdog_trips_total", "heartbeat timeouts",
+                     []() { return (double)watchdog->stats(receiverHeartbeat).trips; }, "source=\"receiver\"");
+    metrics.callback(Metrics::Type::counter, "drivehub_watchdog_trips_total", "heartbeat timeouts",
+                     []() { return (double)watchdog->stats(swiftrobotHeartbeat).trips; }, "source=\"swiftrobot\"");
+    metrics.callback(Metrics::Type::counter, "drivehub_control_loop_ticks_total", "control loop ticks",
+                     []() { return (double)controlLoop->stats().ticks; });
+    metrics.callback(Metrics::Type::counter, "drivehub_control_loop_overruns_total", "ticks which ended after the start of the next period",
+                     []() { return (double)controlLoop->stats().overruns; });
+    metrics.callback(Metrics::Type::gauge, "drivehub_control_loop_max_jitter_seconds", "largest wake up delay of a tick",
+                     []() { return controlLoop->stats().maxJitterNs / 1e9; });
+    metrics.callback(Metrics::Type::counter, "drivehub_recorder_records_total", "records written by the flight recorder",
+                     []() { return (double)recorder->stats().records; });
+    metrics.callback(Metrics::Type::counter, "drivehub_recorder_dropped_total", "records which did not fit into their ring",
+                     []() { return (double)recorder->stats().dropped; });
+    metrics.callback(Metrics::Type::gauge, "drivehub_latency_p99_seconds", "99th percentile of the input to actuator latency",
+                     []() { return core->receiverLatency().percentile(99.0) / 1e9; }, "path=\"sumd_duty\"");
+    metrics.callback(Metrics::Type::gauge, "drivehub_latency_p99_seconds", "99th percentile of the input to actuator latency",
+                     []() { return core->driveLatency().percentile(99.0) / 1e9; }, "path=\"drive_servo\"");
+    metrics.callback(Metrics::Type::gauge, "drivehub_latency_p99_seconds", "99th percentile of the input to actuator latency",
+                     []() { return vescPoller->rtt().percentile(99.0) / 1e9; }, "path=\"vesc_rtt\"");
+    for (size_t i = 0; i < (size_t)VescTxClass::count; i++) {
+        VescTxClass cls = (VescTxClass)i;
+        metrics.callback(Metrics::Type::gauge, "drivehub_vesc_tx_queue_latency_p99_seconds", "99th percentile of the time VESC frames wait for their write",
+                         [cls]() { return vesc->txQueue()->queueLatency(cls).percentile(99.0) / 1e9; },
+                         std::string("class=\"") + vescTxClassName(cls) + "\"");
+    }
+    metrics.callback(Metrics::Type::counter, "drivehub_log_dropped_total", "log records which did not fit into their ring",
+                     []() { return (double)Logger::global().stats().dropped; });
+}
+
+void handleTerminate(int) {
+    running = 0;
+}
+
+void handleDumpLatency(int) {
+    dumpLatency = 1;
 }
 
 int main(int argc, char** argv) {
+    // device paths default to the ones of the car; drivehub_sim prints the paths of its ptys
+    std::string receiverDev = SERIAL_RECEIVER;
+    std::string vescDev = SERIAL_VESC;
+    std::string recordDir = RECORDER_DIR;
+    std::string metricsSocket = METRICS_SOCKET;
+    std::string metricsFile;
+    std::string publishPolicy;
+    bool telemetry = false;
+    static const option options[] = {
+        {"receiver", required_argument, nullptr, 'r'},
+        {"vesc", required_argument, nullptr, 'v'},
+        {"record", required_argument, nullptr, 'o'},
+        {"metrics", required_argument, nullptr, 'm'},
+        {"metrics-file", required_argument, nullptr, 'f'},
+        {"log", required_argument, nullptr, 'l'},
+        {"publish", required_argument, nullptr, 'p'},
+        {"telemetry", no_argument, nullptr, 't'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:v:o:m:f:l:p:th", options, nullptr)) != -1) {
+        switch (opt) {
+        case 'r': receiverDev = optarg; break;
+        case 'v': vescDev = optarg; break;
+        case 'o': recordDir = optarg; break;
+        case 'm': metricsSocket = optarg; break;
+        case 'f': metricsFile = optarg; break;
+        case 'p': publishPolicy = optarg; break;
+        case 't': telemetry = true; break;
+        case 'l':
+            if (Logger::setLevels(optarg)) break;
+            printf("bad log levels '%s', expected e.g. 'info,fsm=debug'\n", optarg);
+            [[fallthrough]];
+        default:
+            printf("usage: %s [--receiver DEV] [--vesc DEV] [--record DIR] [--metrics SOCKET] [--metrics-file FILE] [--log LEVELS] [--publish POLICY] [--telemetry]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // logger before everything else, the other components log from their constructors and threads
+    Logger::global().start(stdout, LOG_FLUSH_INTERVAL);
+
+    // recorder first, so the serial ports register with it
+    recorder = std::make_unique<Recorder>(recordDir, RECORDER_CHUNK_SIZE, RECORDER_MAX_CHUNKS);
+    recorder->start(RECORDER_FLUSH_INTERVAL);
+
     // construct objects
     ledcontroller = std::make_shared<LEDController>();
-    receiver = std::make_shared<Receiver>(SERIAL_RECEIVER, 115200);
-    vesc = std::make_shared<Vesc>(SERIAL_VESC, 115200);
+    reactor = std::make_shared<Reactor>();
+    receiver = std::make_shared<Receiver>(*reactor, receiverDev, 115200);
+    vesc = std::make_shared<Vesc>(*reactor, vescDev, VESC_BAUD);
     swiftrobotclient = std::make_shared<SwiftRobotClient>(2345); // usb connection
 
-    vescStatusPublishTimer = std::make_unique<Timer>();
+    VescPoller::Config pollConfig;
+    pollConfig.idleRate = VESC_POLL_IDLE_RATE;
+    pollConfig.movingRate = VESC_POLL_MOVING_RATE;
+    pollConfig.movingRpm = VESC_POLL_MOVING_RPM;
+    pollConfig.movingHold = VESC_POLL_MOVING_HOLD;
+    pollConfig.timeout = VESC_POLL_TIMEOUT;
+    pollConfig.baud = VESC_BAUD;
+    pollConfig.txShare = VESC_POLL_TX_SHARE;
+    pollConfig.rxShare = VESC_POLL_RX_SHARE;
+    vescPoller = std::make_unique<VescPoller>(*reactor, *vesc, pollConfig);
+
+    // the publish paths do not allocate after this
+    statusMsg.data.reserve(VESC_STATUS_MSG_SIZE);
+    receiverMsg.data.reserve(RECEIVER_MSG_SIZE);
+
+    publisher = std::make_unique<Publisher>();
+    statusTopic = &publisher->addTopic<VescData>("status", PUBLISH_STATUS_DEPTH, PUBLISH_STATUS_POLICY, &publishVescStatus, &vescStatusDistance);
+    receiverTopic = &publisher->addTopic<ReceiverPacket>("receiver", PUBLISH_RECEIVER_DEPTH, PUBLISH_RECEIVER_POLICY, &publishReceiverPacket, &receiverPacketDistance);
+    if (telemetry) {
+        // no publish policy, every sample goes into a frame
+        telemetryMsg.data.reserve(telemetryEncoder.capacity());
+        telemetryTopic = &publisher->addTopic<TelemetrySample>("telemetry", TELEMETRY_QUEUE_DEPTH, DropPolicy::dropOldest, &addTelemetrySample);
+        publisher->addTimer(TELEMETRY_FLUSH_INTERVAL, &flushTelemetry);
+    }
+    if (!publisher->setPolicies(PUBLISH_POLICY) || !publisher->setPolicies(publishPolicy)) {
+        printf("bad publish policy '%s', expected e.g. 'receiver.max=50,status.deadband=0.01'\n", publishPolicy.c_str());
+        exit(1);
+    }
+    publisher->start();
 
     // start FSM in setup
-    context = std::make_unique<Context>(new Setup, swiftrobotclient, vesc, receiver, ledcontroller); // setup is dummy state to signal we are in setup even though everything happens here...
+    context = std::make_unique<Context>(StateId::setup, swiftrobotclient, vesc, receiver, ledcontroller); // setup is dummy state to signal we are in setup even though everything happens here...
+    core = std::make_unique<DriveCore>(*context, &monotonicNs);
+
+    controlLoop = std::make_unique<ControlLoop>(std::bind(&DriveCore::tick, core.get()));
+    watchdog = std::make_unique<Watchdog>();
+    receiverHeartbeat = watchdog->addSource(TIMEOUT_HARDWARE, std::bind(&DriveCore::receiverTimedOut, core.get()));
+    swiftrobotHeartbeat = watchdog->addSource(TIMEOUT_HARDWARE, std::bind(&DriveCore::swiftrobotTimedOut, core.get()));
 
     receiver->setPacketReceivedCallback(&receivedReceiverPacket);
     receiver->start();
@@ -141,11 +303,13 @@ int main(int argc, char** argv) {
     vesc->setStatusReceivedCallback(&receivedVescStatus);
     vesc->start();
 
+    reactor->start(REACTOR_CPU);
+
     swiftrobotclient->subscribe<internal_msg::UpdateMsg>(SR_INTERNAL, &swiftrobotmReceivedInternal);
     swiftrobotclient->subscribe<control_msg::Drive>(SR_DRIVE, &swiftrobotmReceivedDrive);
     swiftrobotclient->start();
 
-    vescStatusPublishTimer->setInterval(&timerTriggeredVescStatusPublish, INTERVAL_VESCSTATUS_PUBLISH);
+    vescPoller->start();
 
     context->swiftrobotConnected = true;
 
@@ -154,16 +318,39 @@ int main(int argc, char** argv) {
     // workaround
     context->manualControl();
 
-    // watchdog
-    while (1) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(INTERVAL_TIMEOUT_CHECK));
-        m_context.lock();
-        if (timedOut(lastReceiverPing, TIMEOUT_HARDWARE)) {
-            context->receiverTimedOut();
-        }
-        if (timedOut(lastSwiftrobotPing, TIMEOUT_HARDWARE)) {
-//            context->swiftrobotTimedOut();
+    controlLoop->start(CONTROL_LOOP_RATE, CONTROL_LOOP_PRIORITY, CONTROL_LOOP_CPU);
+
+    watchdog->start();
+
+    registerMetrics();
+    Metrics::global().start(metricsSocket, metricsFile, METRICS_INTERVAL);
+
+    signal(SIGINT, handleTerminate);
+    signal(SIGTERM, handleTerminate);
+    signal(SIGUSR1, handleDumpLatency);
+
+    // everything runs on its own thread from here
+    while (running) {
+        pause();
+        if (dumpLatency) {
+            dumpLatency = 0;
+            Logger::global().flush();
+            core->receiverLatency().print("sumd -> duty");
+            core->driveLatency().print("drive -> servo");
+            vescPoller->rtt().print("vesc rtt");
+            for (size_t i = 0; i < (size_t)VescTxClass::count; i++) {
+                std::string name = std::string("tx ") + vescTxClassName((VescTxClass)i);
+                vesc->txQueue()->queueLatency((VescTxClass)i).print(name.c_str());
+            }
+            fflush(stdout);
         }
-        m_context.unlock();
     }
+
+    // keep the last records, then leave without tearing down the other threads
+    controlLoop->stop();
+    recorder->stop();
+    publisher->stop();
+    Metrics::global().stop();
+    Logger::global().stop();
+    _exit(0);
 }
@@ -0,0 +1,240 @@
+#include "metrics.hpp"
+#include "log.hpp"
+#include "clock.hpp"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+Metrics::Metrics() : interval_(1000) {}
+
+Metrics::~Metrics() {
+    stop();
+}
+
+Metrics& Metrics::global() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Series& Metrics::series(Type type, const std::string& name, const std::string& help, const std::string& labels,
+                                 bool& created) {
+    Family* family = nullptr;
+    for (auto& f : families_) {
+        if (f->name == name) {
+            family = f.get();
+            break;
+        }
+    }
+    if (!family) {
+        families_.push_back(std::make_unique<Family>());
+        family = families_.back().get();
+        family->name = name;
+        family->help = help;
+        family->type = type;
+    }
+    for (auto& s : family->series) {
+        if (s->labels == labels) {
+            created = false;
+            return *s;
+        }
+    }
+    family->series.push_back(std::make_unique<Series>());
+    family->series.back()->labels = labels;
+    created = true;
+    return *family->series.back();
+}
+
+Counter& Metrics::counter(const std::string& name, const std::string& help, const std::string& labels,
+                          const std::string& rateName) {
+    std::lock_guard<std::mutex> lock(m_);
+    bool created;
+    Series& s = series(Type::counter, name, help, labels, created);
+    if (!s.counter) {
+        s.counter = std::make_unique<Counter>();
+    }
+    if (!rateName.empty()) {
+        Series& rate = series(Type::gauge, rateName, help + " (per second)", labels, created);
+        rate.rateOf = s.counter.get();
+        rate.rateLast = s.counter->value();
+    }
+    return *s.counter;
+}
+
+Gauge& Metrics::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_);
+    bool created;
+    Series& s = series(Type::gauge, name, help, labels, created);
+    if (!s.gauge) {
+        s.gauge = std::make_unique<Gauge>();
+    }
+    return *s.gauge;
+}
+
+void Metrics::callback(Type type, const std::string& name, const std::string& help, std::function<double(void)> read,
+                       const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_);
+    bool created;
+    series(type, name, help, labels, created).read = read;
+}
+
+std::string Metrics::render() {
+    std::lock_guard<std::mutex> lock(m_);
+    std::string out;
+    out.reserve(8192);
+    char line[256];
+    for (const auto& family : families_) {
+        out += "# HELP " + family->name + " " + family->help + "\n";
+        out += "# TYPE " + family->name + (family->type == Type::counter ? " counter\n" : " gauge\n");
+        for (const auto& s : family->series) {
+            double value = 0;
+            if (s->counter) {
+                value = (double)s->counter->value();
+            } else if (s->gauge) {
+                value = (double)s->gauge->value();
+            } else if (s->read) {
+                value = s->read();
+            } else if (s->rateOf) {
+                value = s->rate;
+            }
+            out += family->name;
+            if (!s->labels.empty()) {
+                out += "{" + s->labels + "}";
+            }
+            snprintf(line, sizeof(line), " %.15g\n", value);
+            out += line;
+        }
+    }
+    return out;
+}
+
+void Metrics::updateRates(double seconds) {
+    std::lock_guard<std::mutex> lock(m_);
+    for (auto& family : families_) {
+        for (auto& s : family->series) {
+            if (s->rateOf) {
+                uint64_t value = s->rateOf->value();
+                s->rate = (value - s->rateLast) / seconds;
+                s->rateLast = value;
+            }
+        }
+    }
+}
+
+bool Metrics::start(const std::string& socketPath, const std::string& filePath, std::chrono::milliseconds interval) {
+    if (thread_.joinable()) {
+        return true;
+    }
+    socketPath_ = socketPath;
+    filePath_ = filePath;
+    interval_ = interval;
+    stopFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    bool ok = true;
+    if (!socketPath_.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socketPath_.size() >= sizeof(addr.sun_path)) {
+            LOG_WARN(metrics, "socket path '%s' is too long", socketPath_.c_str());
+            ok = false;
+        } else {
+            strncpy(addr.sun_path, socketPath_.c_str(), sizeof(addr.sun_path) - 1);
+            listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            // a socket file left by a previous run would make bind fail
+            unlink(socketPath_.c_str());
+            if (listenFd_ < 0 || bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd_, 4) < 0) {
+                LOG_WARN(metrics, "could not serve on '%s': %s", socketPath_.c_str(), strerror(errno));
+                if (listenFd_ >= 0) {
+                    close(listenFd_);
+                    listenFd_ = -1;
+                }
+                ok = false;
+            }
+        }
+    }
+    thread_ = std::thread(&Metrics::run, this);
+    return ok;
+}
+
+void Metrics::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    uint64_t one = 1;
+    if (write(stopFd_, &one, sizeof(one)) < 0) {
+        // the thread still wakes up for the next interval
+    }
+    thread_.join();
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        unlink(socketPath_.c_str());
+        listenFd_ = -1;
+    }
+    close(stopFd_);
+    stopFd_ = -1;
+}
+
+/// writes to a temporary file first, so readers never see a half written one
+void Metrics::writeFile() {
+    std::string text = render();
+    std::string tmp = filePath_ + ".tmp";
+    FILE* file = fopen(tmp.c_str(), "w");
+    if (!file) {
+        return;
+    }
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = fclose(file) == 0 && ok;
+    if (ok) {
+        rename(tmp.c_str(), filePath_.c_str());
+    }
+}
+
+void Metrics::run() {
+    const int64_t intervalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(interval_).count();
+    int64_t last = monotonicNs();
+    int64_t next = last + intervalNs;
+    pollfd fds[2];
+    fds[0] = {stopFd_, POLLIN, 0};
+    fds[1] = {listenFd_, POLLIN, 0};
+    while (true) {
+        int64_t wait = (next - monotonicNs()) / 1000000;
+        int n = poll(fds, listenFd_ >= 0 ? 2 : 1, wait > 0 ? (int)wait : 0);
+        if (n > 0 && (fds[0].revents & POLLIN)) {
+            return;
+        }
+        if (n > 0 && (fds[1].revents & POLLIN)) {
+            // non blocking: a page fits into the socket buffer, a client which does not read it must not stall
+            // the rate updates. On EAGAIN the page is cut off and the client gets what was sent so far
+            int client = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (client >= 0) {
+                std::string text = render();
+                size_t sent = 0;
+                while (sent < text.size()) {
+                    ssize_t w = send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+                    if (w < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (w <= 0) {
+                        break;
+                    }
+                    sent += (size_t)w;
+                }
+                close(client);
+            }
+        }
+        int64_t now = monotonicNs();
+        if (now >= next) {
+            updateRates((now - last) / 1e9);
+            if (!filePath_.empty()) {
+                writeFile();
+            }
+            last = now;
+            next = now + intervalNs;
+        }
+    }
+}
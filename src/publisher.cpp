@@ -0,0 +1,174 @@
+#include "publisher.hpp"
+#include "log.hpp"
+#include "clock.hpp"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+Publisher::Publisher() {
+    wakeFd_ = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd_ < 0) {
+        printf("Publisher: could not create eventfd. Terminating.\n");
+        exit(1);
+    }
+}
+
+Publisher::~Publisher() {
+    stop();
+    close(wakeFd_);
+}
+
+void Publisher::addTimer(std::chrono::nanoseconds interval, std::function<void(void)> fn) {
+    timers_.push_back(Timer{interval.count(), 0, std::move(fn)});
+}
+
+bool Publisher::setPolicy(const std::string& topic, const PublishPolicy& policy) {
+    for (auto& t : topics_) {
+        if (t->name_ == topic) {
+            t->policy_ = policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Publisher::setPolicies(const std::string& spec) {
+    bool ok = true;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        std::string part = spec.substr(start, end - start);
+        start = end + 1;
+        if (part.empty()) {
+            continue;
+        }
+        size_t dot = part.find('.');
+        size_t eq = part.find('=');
+        if (dot == std::string::npos || eq == std::string::npos || eq < dot) {
+            ok = false;
+            continue;
+        }
+        std::string name = part.substr(0, dot);
+        std::string key = part.substr(dot + 1, eq - dot - 1);
+        std::string value = part.substr(eq + 1);
+        char* rest = nullptr;
+        double number = strtod(value.c_str(), &rest);
+        auto topic = std::find_if(topics_.begin(), topics_.end(), [&](const std::unique_ptr<TopicBase>& t) { return t->name_ == name; });
+        if (topic == topics_.end() || value.empty() || *rest != 0) {
+            ok = false;
+            continue;
+        }
+        PublishPolicy& policy = (*topic)->policy_;
+        if (key == "max" && number >= 0) {
+            policy.maxRate = number;
+        } else if (key == "min" && number >= 0) {
+            policy.minRate = number;
+        } else if (key == "deadband") {
+            policy.deadband = number;
+        } else {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void Publisher::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    int64_t now = monotonicNs();
+    for (auto& timer : timers_) {
+        timer.nextNs = now + timer.intervalNs;
+    }
+    thread_ = std::thread(&Publisher::run, this);
+}
+
+void Publisher::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    wake();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    int64_t next;
+    drainAll(next);
+    // e.g. flushes the last batch
+    for (auto& timer : timers_) {
+        timer.fn();
+    }
+}
+
+void Publisher::wake() {
+    uint64_t one = 1;
+    if (write(wakeFd_, &one, sizeof(one)) < 0) {
+        LOG_WARN(swiftrobot, "Publisher: could not wake the publisher thread");
+    }
+}
+
+size_t Publisher::drainAll(int64_t& nextNs) {
+    size_t n = 0;
+    int64_t now = monotonicNs();
+    nextNs = INT64_MAX;
+    for (auto& topic : topics_) {
+        n += topic->drain(now, nextNs);
+    }
+    for (auto& timer : timers_) {
+        if (now >= timer.nextNs) {
+            timer.fn();
+            timer.nextNs += timer.intervalNs;
+            if (timer.nextNs <= now) {
+                timer.nextNs = now + timer.intervalNs; // skips missed intervals instead of catching up
+            }
+        }
+        nextNs = std::min(nextNs, timer.nextNs);
+    }
+    return n;
+}
+
+void Publisher::run() {
+    int64_t next;
+    while (running_.load()) {
+        if (drainAll(next) > 0) {
+            continue;
+        }
+        sleeping_.store(true, std::memory_order_relaxed);
+        // pairs with the fence in notify(), then look again before sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (drainAll(next) > 0) {
+            sleeping_.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        // until a value comes in or a held back value or heartbeat is due
+        timespec timeout;
+        timespec* until = nullptr;
+        if (next != INT64_MAX) {
+            int64_t wait = std::max<int64_t>(next - monotonicNs(), 0);
+            timeout.tv_sec = wait / 1000000000LL;
+            timeout.tv_nsec = wait % 1000000000LL;
+            until = &timeout;
+        }
+        pollfd fd{wakeFd_, POLLIN, 0};
+        int ready = ppoll(&fd, 1, until, nullptr);
+        if (ready < 0 && errno != EINTR) {
+            LOG_ERROR(swiftrobot, "Publisher: could not wait for values");
+            return;
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+        if (ready > 0) {
+            // a wake up from a value which was already drained only costs one more empty pass
+            uint64_t count;
+            if (read(wakeFd_, &count, sizeof(count)) < 0) {
+                LOG_WARN(swiftrobot, "Publisher: could not reset the wake up");
+            }
+        }
+    }
+}
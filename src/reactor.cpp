@@ -0,0 +1,44 @@
+#include "reactor.hpp"
+#include "log.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+// concurrency hint of 1: only one thread runs handlers, so asio queues handlers posted from that thread without
+// locking. The scheduler keeps its mutex (only BOOST_ASIO_CONCURRENCY_HINT_UNSAFE removes it), so the control loop,
+// watchdog and timer threads can still post, e.g. through VescTxQueue::send
+Reactor::Reactor() : io_(1), work_(boost::asio::make_work_guard(io_)) {}
+
+Reactor::~Reactor() {
+    stop();
+}
+
+void Reactor::start(int cpu) {
+    if (running_.exchange(true)) {
+        return;
+    }
+    io_.restart();
+    thread_ = std::thread([this]() {
+        io_.run();
+    });
+    if (cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        if (pthread_setaffinity_np(thread_.native_handle(), sizeof(cpu_set_t), &cpuset) != 0) {
+            LOG_WARN(core, "Reactor: could not pin thread to cpu %d", cpu);
+        }
+    }
+}
+
+void Reactor::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    io_.stop();
+    if (thread_.joinable() && std::this_thread::get_id() != thread_.get_id()) {
+        thread_.join();
+    } else if (thread_.joinable()) {
+        thread_.detach(); // stopped from within a handler
+    }
+}
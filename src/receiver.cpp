@@ -1,28 +1,36 @@
 #include "receiver.hpp"
+#include "log.hpp"
 
-//#define DEBUGGING
-#ifdef DEBUGGING
-#define DBG_PRINT(x...) printf(x)
-#else
-#define DBG_PRINT(x...) //
-#endif
-
-Receiver::Receiver(std::string dev, uint32_t baud) : packet{0}, ser(std::make_unique<Serial>(dev, baud)) {
+Receiver::Receiver(Reactor& reactor, std::string dev, uint32_t baud) : ser(std::make_unique<Serial>(reactor, dev, baud, false, "receiver")) {
 }
 
-/// starts the thread for async read on serial
+Receiver::Receiver() {}
+
+/// registers async read on serial with the reactor
 void Receiver::start() {
+    if (!ser) {
+        return;
+    }
     ser->startAsync(std::bind(&Receiver::uartReceive, this, std::placeholders::_1, std::placeholders::_2));
 }
 
-void Receiver::uartReceive(uint8_t* data, size_t size) {
-    for (int i = 0; i < size; i++) {
-        buffer_.push(data[i]);
+void Receiver::feed(ByteSpan data, int64_t timestampNs) {
+    feedTimeNs_ = timestampNs;
+    // the ring only takes what fits, so long replay reads are fed in pieces
+    while (!data.empty()) {
+        size_t n = data.size() < BUF_LEN ? data.size() : BUF_LEN;
+        uartReceive(const_cast<uint8_t*>(data.data()), n);
+        data = data.subspan(n);
     }
+}
+
+void Receiver::uartReceive(uint8_t* data, size_t size) {
+    buffer_.write(ByteSpan(data, size));
     if (analyzePacket() > 0) {
         ReceiverPacket tmp_packet;
-        if (this->packet.state == 1) {
-          SumD_to_ReceiverPacket(this->packet, &tmp_packet);
+        if (parser_.packet().state == STATE_NORMAL) {
+          SumD_to_ReceiverPacket(parser_.packet(), &tmp_packet);
+          tmp_packet.timestampNs = ser ? ser->lastReceiveTime() : feedTimeNs_;
           packetReceivedCallback(tmp_packet);
         }
     }
@@ -33,65 +41,32 @@ void Receiver::setPacketReceivedCallback(std::function<void(ReceiverPacket data)
     packetReceivedCallback = callback;
 }
 
-void Receiver::SumD_to_ReceiverPacket(SumD_Packet sumd, ReceiverPacket *packet) {
+void Receiver::SumD_to_ReceiverPacket(const SumD_Packet& sumd, ReceiverPacket *packet) {
     packet->throttle = convertThrottleRange(getPercent(sumd, THROTTLE_CHANNEL));
     packet->steering = convertSteeringRange(getPercent(sumd, STEERING_CHANNEL));
     packet->gearSelector = (getPercent(sumd, GEAR_CHANNEL) > 0.0) ? drive : reverse;
     packet->lateral_control = (getPercent(sumd, AUTONOMOUS_CHANNEL) > -0.5) ? true : false;
     packet->autonomous = (getPercent(sumd, AUTONOMOUS_CHANNEL) > 0.5) ? true : false;
     
-    DBG_PRINT("throttle: %f steering: %f gear: %d lanekeep: %d, autonomous: %d \n", lastReceiverData.throttle, lastReceiverData.steering, lastReceiverData.gearSelector, lastReceiverData.lanekeep, lastReceiverData.autonomous);
-}
-
-uint16_t Receiver::sumd_crc16(int len) {
-    unsigned int i;
-	unsigned short cksum = 0;
-	for (i = 0; i < len; i++) {
-		cksum = crc16_tab[(((cksum >> 8) ^ buffer_[i]) & 0xFF)] ^ (cksum << 8);
-	}
-	return cksum;
+    LOG_TRACE(receiver, "throttle: %f steering: %f gear: %d lateral: %d autonomous: %d", packet->throttle, packet->steering,
+              packet->gearSelector, packet->lateral_control, packet->autonomous);
 }
 
+/// runs all buffered bytes through the decoder. Returns the number of complete frames
 int Receiver::analyzePacket()
 {
-    int retCount = 0;
-    while(buffer_.available() >= SUMD_PAKET_MINSIZE)
-    {
-        // check for paket type
-        if(buffer_[0] != MAN_ID) {
-            buffer_.pop(1); // throw away until first byte is right
-            continue;
-        }
-        recvNumChannels = buffer_[2];
-        if(recvNumChannels > MAX_CHAN_COUNT)
-        {
-            buffer_.pop(1);
-            continue;
-        }
-        DBG_PRINT("NUM CHANNELS: d\n", recvNumChannels);
-        int payloadSize = 3 + 2 * recvNumChannels;
-        // check crc
-        uint16_t crc = sumd_crc16(payloadSize + 2); // crc bytes included
-        if(crc != 0)
-        {
-            DBG_PRINT("CRC failed");
-            buffer_.pop(1);
-            continue;
-        }
+    RingBuffer<64>::Spans spans = buffer_.peekContiguous();
+    int retCount = parser_.feed(spans.first) + parser_.feed(spans.second);
+    buffer_.pop(spans.size());
 
-        // copy paket
-        uint8_t *ptr = (uint8_t *)&packet;
-        ptr[0] = buffer_[0];
-        ptr[1] = buffer_[1];
-        ptr[2] = buffer_[2];
-        for(int i = 3; i < payloadSize + 2; i += 2)
-        {
-            ptr[i] = buffer_[i];
-            ptr[i + 1] = buffer_[i+1];
-        }
-        buffer_.pop(payloadSize + 2);
-        retCount++;
-        DBG_PRINT("Got Paket: %d", paket.state);
+    frames_.add(retCount);
+    if (parser_.crcErrors() != crcErrorsSeen_) {
+        crcErrors_.add(parser_.crcErrors() - crcErrorsSeen_);
+        crcErrorsSeen_ = parser_.crcErrors();
+    }
+    if (parser_.skippedBytes() != skippedBytesSeen_) {
+        skippedBytes_.add(parser_.skippedBytes() - skippedBytesSeen_);
+        skippedBytesSeen_ = parser_.skippedBytes();
     }
     return retCount;
 }
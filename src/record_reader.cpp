@@ -0,0 +1,107 @@
+#include "record_reader.hpp"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+int Recording::findSource(const std::string& prefix) const {
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i].compare(0, prefix.size(), prefix) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool loadRecording(const std::string& dir, Recording& out, int64_t run) {
+    struct Chunk {
+        uint64_t index;
+        std::string path;
+        ChunkHeader header;
+    };
+    std::vector<Chunk> chunks;
+
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return false;
+    }
+    while (dirent* entry = readdir(d)) {
+        unsigned long long index;
+        if (sscanf(entry->d_name, "flight-%llu.bin", &index) != 1) {
+            continue;
+        }
+        Chunk chunk;
+        chunk.index = index;
+        chunk.path = dir + "/" + entry->d_name;
+        FILE* file = fopen(chunk.path.c_str(), "rb");
+        if (file == nullptr) {
+            continue;
+        }
+        bool ok = fread(&chunk.header, sizeof(chunk.header), 1, file) == 1;
+        fclose(file);
+        if (ok && chunk.header.magic == RECORDER_FILE_MAGIC && chunk.header.version == RECORDER_FILE_VERSION) {
+            chunks.push_back(chunk);
+        }
+    }
+    closedir(d);
+
+    if (run == 0) {
+        for (const Chunk& chunk : chunks) {
+            run = std::max(run, chunk.header.run);
+        }
+    }
+    chunks.erase(std::remove_if(chunks.begin(), chunks.end(), [&](const Chunk& c) { return c.header.run != run; }), chunks.end());
+    std::sort(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b) { return a.index < b.index; });
+    if (chunks.empty()) {
+        return false;
+    }
+
+    out = Recording();
+    out.run = run;
+    std::vector<uint8_t> file;
+    for (const Chunk& chunk : chunks) {
+        if (!readFile(chunk.path, file)) {
+            continue;
+        }
+        // 'used' is kept up to date while recording, so a chunk of a crashed run is readable too
+        size_t end = std::min(file.size(), sizeof(ChunkHeader) + (size_t)chunk.header.used);
+        size_t pos = sizeof(ChunkHeader);
+        while (pos + sizeof(RecordHeader) <= end) {
+            Record record;
+            memcpy(&record.header, &file[pos], sizeof(RecordHeader));
+            pos += sizeof(RecordHeader);
+            if (record.header.type == RecordType::none || pos + record.header.length > end) {
+                break;
+            }
+            if (record.header.type == RecordType::source) {
+                if (out.sources.size() <= record.header.source) {
+                    out.sources.resize(record.header.source + 1);
+                }
+                out.sources[record.header.source].assign(reinterpret_cast<const char*>(&file[pos]), record.header.length);
+            } else {
+                record.offset = out.data.size();
+                out.data.insert(out.data.end(), file.begin() + pos, file.begin() + pos + record.header.length);
+                out.records.push_back(record);
+            }
+            pos += record.header.length;
+        }
+    }
+    // rings are drained one after another, so records of different threads are not in order
+    std::stable_sort(out.records.begin(), out.records.end(), [](const Record& a, const Record& b) {
+        return a.header.timestampNs < b.header.timestampNs;
+    });
+    return true;
+}
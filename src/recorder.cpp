@@ -0,0 +1,275 @@
+#include "recorder.hpp"
+#include "log.hpp"
+#include "clock.hpp"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+std::atomic<Recorder*> Recorder::active_{nullptr};
+std::atomic<uint64_t> Recorder::nextId_{1};
+
+static std::string chunkPath(const std::string& dir, uint64_t index) {
+    char name[32];
+    snprintf(name, sizeof(name), "flight-%06llu.bin", (unsigned long long)index);
+    return dir + "/" + name;
+}
+
+Recorder::Recorder(const std::string& dir, size_t chunkSize, size_t maxChunks)
+    : id_(nextId_.fetch_add(1)), dir_(dir), chunkSize_(chunkSize), maxChunks_(maxChunks > 0 ? maxChunks : 1) {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    run_ = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    // continue after the chunks of the last run, they count towards the limit
+    DIR* d = opendir(dir_.c_str());
+    if (d != nullptr) {
+        bool found = false;
+        uint64_t first = 0, last = 0;
+        while (dirent* entry = readdir(d)) {
+            unsigned long long index;
+            if (sscanf(entry->d_name, "flight-%llu.bin", &index) == 1) {
+                first = found ? std::min(first, (uint64_t)index) : index;
+                last = found ? std::max(last, (uint64_t)index) : index;
+                found = true;
+            }
+        }
+        closedir(d);
+        if (found) {
+            firstChunk_ = first;
+            chunkIndex_ = last + 1;
+        }
+    }
+}
+
+Recorder::~Recorder() {
+    stop();
+}
+
+bool Recorder::start(std::chrono::milliseconds flushInterval) {
+    if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+        LOG_WARN(recorder, "could not create '%s', recording is off", dir_.c_str());
+        return false;
+    }
+    if (running_.exchange(true)) {
+        return true;
+    }
+    thread_ = std::thread(&Recorder::run, this, flushInterval);
+    active_.store(this, std::memory_order_release);
+    return true;
+}
+
+void Recorder::stop() {
+    Recorder* self = this;
+    active_.compare_exchange_strong(self, nullptr);
+    if (running_.exchange(false) && thread_.joinable()) {
+        thread_.join();
+    }
+    flush();
+    std::lock_guard<std::mutex> lock(m_);
+    closeChunk();
+}
+
+void Recorder::flush() {
+    std::lock_guard<std::mutex> lock(m_);
+    for (auto& ring : rings_) {
+        drain(*ring);
+    }
+}
+
+uint8_t Recorder::sourceId(const std::string& name) {
+    uint8_t id;
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        auto it = std::find(sources_.begin(), sources_.end(), name);
+        if (it != sources_.end()) {
+            return (uint8_t)(it - sources_.begin());
+        }
+        id = (uint8_t)sources_.size();
+        sources_.push_back(name);
+    }
+    record(RecordType::source, id, ByteSpan(reinterpret_cast<const uint8_t*>(name.data()), name.size()));
+    return id;
+}
+
+Recorder::ThreadRing& Recorder::threadRing() {
+    // rings are never freed while the recorder lives, so the cached pointer stays valid
+    // (compared by id, a new recorder can get the address of a destroyed one)
+    thread_local uint64_t owner = 0;
+    thread_local ThreadRing* ring = nullptr;
+    if (owner != id_) {
+        std::lock_guard<std::mutex> lock(m_);
+        rings_.push_back(std::make_unique<ThreadRing>());
+        ring = rings_.back().get();
+        owner = id_;
+    }
+    return *ring;
+}
+
+void Recorder::record(RecordType type, uint8_t source, ByteSpan payload) {
+    ThreadRing& tr = threadRing();
+    size_t len = std::min(payload.size(), (size_t)UINT16_MAX);
+    // all or nothing, so the flush thread never sees half a record
+    if (tr.ring.space() < sizeof(RecordHeader) + len) {
+        tr.seq++;
+        tr.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    RecordHeader header;
+    header.timestampNs = monotonicNs();
+    header.seq = tr.seq++;
+    header.length = (uint16_t)len;
+    header.type = type;
+    header.source = source;
+    tr.ring.write(ByteSpan(reinterpret_cast<const uint8_t*>(&header), sizeof(header)));
+    tr.ring.write(payload.subspan(0, len));
+}
+
+RecorderStats Recorder::stats() {
+    RecorderStats s;
+    s.records = records_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.chunks = chunks_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_);
+    for (auto& ring : rings_) {
+        s.dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+void Recorder::run(std::chrono::milliseconds flushInterval) {
+    while (running_.load()) {
+        std::this_thread::sleep_for(flushInterval);
+        flush();
+    }
+}
+
+/// moves all complete records of a ring into the chunk. Called with m_ held
+size_t Recorder::drain(ThreadRing& tr) {
+    auto& ring = tr.ring;
+    size_t count = 0;
+    while (true) {
+        size_t available = ring.available();
+        if (available < sizeof(RecordHeader)) {
+            break;
+        }
+        RecordHeader header;
+        uint8_t* raw = reinterpret_cast<uint8_t*>(&header);
+        for (size_t i = 0; i < sizeof(header); i++) {
+            raw[i] = ring[i];
+        }
+        size_t total = sizeof(header) + header.length;
+        if (available < total) {
+            break; // payload is still being written
+        }
+        RingBuffer<RECORDER_RING_SIZE>::Spans spans = ring.peekContiguous();
+        // cut the payload out of the two spans
+        ByteSpan first, second;
+        if (spans.first.size() >= total) {
+            first = spans.first.subspan(sizeof(header), header.length);
+        } else if (spans.first.size() > sizeof(header)) {
+            first = spans.first.subspan(sizeof(header));
+            second = spans.second.subspan(0, header.length - first.size());
+        } else {
+            first = spans.second.subspan(sizeof(header) - spans.first.size(), header.length);
+        }
+        append(header, first, second);
+        ring.pop(total);
+        count++;
+    }
+    return count;
+}
+
+/// called with m_ held
+void Recorder::append(const RecordHeader& header, ByteSpan first, ByteSpan second) {
+    size_t total = sizeof(header) + first.size() + second.size();
+    if (map_ == nullptr || offset_ + total > chunkSize_) {
+        closeChunk();
+        if (!openChunk()) {
+            return;
+        }
+    }
+    memcpy(map_ + offset_, &header, sizeof(header));
+    if (!first.empty()) {
+        memcpy(map_ + offset_ + sizeof(header), first.data(), first.size());
+    }
+    if (!second.empty()) {
+        memcpy(map_ + offset_ + sizeof(header) + first.size(), second.data(), second.size());
+    }
+    offset_ += total;
+    reinterpret_cast<ChunkHeader*>(map_)->used = offset_ - sizeof(ChunkHeader);
+    records_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(total, std::memory_order_relaxed);
+}
+
+/// called with m_ held
+bool Recorder::openChunk() {
+    std::string path = chunkPath(dir_, chunkIndex_);
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (ftruncate(fd_, chunkSize_) != 0) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    void* map = mmap(nullptr, chunkSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+
+    ChunkHeader chunk;
+    chunk.index = chunkIndex_;
+    chunk.startNs = monotonicNs();
+    chunk.used = 0;
+    chunk.run = run_;
+    memcpy(map_, &chunk, sizeof(chunk));
+    offset_ = sizeof(chunk);
+    chunkIndex_++;
+    chunks_.fetch_add(1, std::memory_order_relaxed);
+
+    // bounded disk usage: the oldest chunks go
+    while (chunkIndex_ - firstChunk_ > maxChunks_) {
+        unlink(chunkPath(dir_, firstChunk_).c_str());
+        firstChunk_++;
+    }
+    writeSources();
+    return true;
+}
+
+/// unmaps the chunk and cuts the file to the used size. Called with m_ held
+void Recorder::closeChunk() {
+    if (map_ == nullptr) {
+        return;
+    }
+    munmap(map_, chunkSize_);
+    map_ = nullptr;
+    if (ftruncate(fd_, offset_) != 0) {
+        LOG_WARN(recorder, "could not truncate chunk");
+    }
+    close(fd_);
+    fd_ = -1;
+}
+
+/// every chunk starts with the source names, so it can be read on its own. Called with m_ held
+void Recorder::writeSources() {
+    for (size_t i = 0; i < sources_.size(); i++) {
+        RecordHeader header{};
+        header.timestampNs = monotonicNs();
+        header.length = (uint16_t)sources_[i].size();
+        header.type = RecordType::source;
+        header.source = (uint8_t)i;
+        append(header, ByteSpan(reinterpret_cast<const uint8_t*>(sources_[i].data()), sources_[i].size()), ByteSpan());
+    }
+}
@@ -0,0 +1,120 @@
+#include "scheduler.hpp"
+
+std::shared_ptr<Scheduler> Scheduler::shared() {
+    static std::shared_ptr<Scheduler> scheduler = std::make_shared<Scheduler>();
+    return scheduler;
+}
+
+Scheduler::Scheduler() {
+    thread_ = std::thread(&Scheduler::run, this);
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        active_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable() && std::this_thread::get_id() != thread_.get_id()) {
+        thread_.join();
+    } else if (thread_.joinable()) {
+        thread_.detach();
+    }
+}
+
+int Scheduler::create() {
+    std::lock_guard<std::mutex> lock(m_);
+    if (!freeSlots_.empty()) {
+        int id = freeSlots_.back();
+        freeSlots_.pop_back();
+        return id;
+    }
+    slots_.emplace_back();
+    return (int)slots_.size() - 1;
+}
+
+void Scheduler::destroy(int id) {
+    cancel(id);
+    std::lock_guard<std::mutex> lock(m_);
+    slots_[id].function = nullptr;
+    freeSlots_.push_back(id);
+}
+
+void Scheduler::arm(int id, std::function<void(void)> function, Clock::duration delay, Clock::duration interval) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        Slot& slot = slots_[id];
+        slot.function = std::move(function);
+        slot.interval = interval;
+        slot.generation++;
+        slot.armed = true;
+        Entry entry{Clock::now() + delay, id, slot.generation};
+        // only a new earliest deadline has to wake the thread up
+        wake = heap_.empty() || entry.deadline < heap_.top().deadline;
+        heap_.push(entry);
+    }
+    if (wake) {
+        cv_.notify_one();
+    }
+}
+
+void Scheduler::cancel(int id) {
+    std::unique_lock<std::mutex> lock(m_);
+    Slot& slot = slots_[id];
+    slot.generation++;
+    slot.armed = false;
+    // stale heap entry is dropped when it comes up, no need to search for it
+    if (std::this_thread::get_id() != thread_.get_id()) {
+        idle_.wait(lock, [&]{ return running_ != id; });
+    }
+}
+
+SchedulerStats Scheduler::stats() {
+    std::lock_guard<std::mutex> lock(m_);
+    return stats_;
+}
+
+void Scheduler::run() {
+    std::unique_lock<std::mutex> lock(m_);
+    while (active_) {
+        if (heap_.empty()) {
+            cv_.wait(lock);
+            stats_.wakeups++;
+            continue;
+        }
+        Entry entry = heap_.top();
+        if (slots_[entry.id].generation != entry.generation) {
+            heap_.pop(); // cancelled or re-armed
+            continue;
+        }
+        if (Clock::now() < entry.deadline) {
+            cv_.wait_until(lock, entry.deadline);
+            stats_.wakeups++;
+            continue;
+        }
+        heap_.pop();
+
+        Slot& slot = slots_[entry.id];
+        if (slot.interval > Clock::duration::zero()) {
+            // schedule from the deadline, not from now, so the interval does not drift
+            Clock::time_point next = entry.deadline + slot.interval;
+            if (next < Clock::now()) {
+                next = Clock::now() + slot.interval;
+            }
+            heap_.push(Entry{next, entry.id, entry.generation});
+        } else {
+            slot.armed = false;
+        }
+        std::function<void(void)> function = slot.function;
+        running_ = entry.id;
+        stats_.fired++;
+
+        lock.unlock();
+        function();
+        lock.lock();
+
+        running_ = -1;
+        idle_.notify_all();
+    }
+}
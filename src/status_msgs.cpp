@@ -0,0 +1,44 @@
+#include "status_msgs.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void vescStatusMsg(const VescData& data, base_msg::UInt32Array& msg) {
+    msg.data.resize(VESC_STATUS_MSG_SIZE); // keeps the capacity of the last fill
+    // for float we are using the same scales as VESC (e.g. vesc.cpp->analyzePacket())
+    msg.data[0] = (uint32_t)(data.mosfet_temp*10);
+    msg.data[1] = (uint32_t)(data.motor_temp*10);
+    msg.data[2] = (uint32_t) data.rpm;
+    msg.data[3] = (uint32_t) (data.voltage*10);
+    msg.data[4] = (uint32_t) data.ticks;
+    msg.data[5] = (uint32_t) data.ticksAbs;
+}
+
+void receiverPacketMsg(const ReceiverPacket& packet, base_msg::UInt16Array& msg) {
+    msg.data.resize(RECEIVER_MSG_SIZE);
+    msg.data[0] = (uint16_t)(packet.throttle*65000); // this maps throttle to 0-65000
+    msg.data[1] = (uint16_t)(packet.steering*65000); // this maps steering to 0-65000
+    msg.data[2] = (uint16_t) packet.gearSelector; // 0 = undefined, 1 = drive, 2 = reverse
+    msg.data[3] = (uint16_t) packet.lateral_control; // 0 false, 1 true
+    msg.data[4] = (uint16_t) packet.autonomous; // 0 false, 1 true
+}
+
+/// change relative to the larger value, so small absolute values are not too sensitive
+static double relativeChange(double a, double b) {
+    return std::fabs(a - b) / std::max({std::fabs(a), std::fabs(b), 1.0});
+}
+
+double vescStatusDistance(const VescData& a, const VescData& b) {
+    if (a.ticks != b.ticks || a.ticksAbs != b.ticksAbs) {
+        return INFINITY; // odometry, every tick matters
+    }
+    return std::max({relativeChange(a.mosfet_temp, b.mosfet_temp), relativeChange(a.motor_temp, b.motor_temp),
+                     relativeChange(a.rpm, b.rpm), relativeChange(a.voltage, b.voltage)});
+}
+
+double receiverPacketDistance(const ReceiverPacket& a, const ReceiverPacket& b) {
+    if (a.gearSelector != b.gearSelector || a.lateral_control != b.lateral_control || a.autonomous != b.autonomous) {
+        return INFINITY;
+    }
+    return std::max(std::fabs(a.throttle - b.throttle), std::fabs(a.steering - b.steering));
+}
@@ -0,0 +1,101 @@
+#include "sumd_parser.hpp"
+#include "crc.h"
+
+SumdParser::SumdParser() : step_(Step::header), crc_(0), channelIdx_(0), frameLen_(0),
+                           frame_{}, packet_{}, crcErrors_(0), skippedBytes_(0) {}
+
+void SumdParser::reset() {
+    step_ = Step::header;
+    frameLen_ = 0;
+}
+
+int SumdParser::feed(ByteSpan data) {
+    int frames = 0;
+    for (uint8_t byte : data) {
+        if (push(byte)) {
+            frames++;
+        }
+    }
+    return frames;
+}
+
+bool SumdParser::push(uint8_t byte) {
+    switch (step_) {
+    case Step::header:
+        if (!startFrame(byte)) {
+            skippedBytes_++;
+        }
+        return false;
+    case Step::status:
+        if (byte != STATE_NORMAL && byte != STATE_FS) {
+            // header byte was noise, but this one could be the start of the real frame
+            dropFrame();
+            if (!startFrame(byte)) {
+                skippedBytes_++;
+            }
+            return false;
+        }
+        frame_.state = byte;
+        step_ = Step::numChannels;
+        break;
+    case Step::numChannels:
+        if (byte == 0 || byte > MAX_CHAN_COUNT) {
+            dropFrame();
+            if (!startFrame(byte)) {
+                skippedBytes_++;
+            }
+            return false;
+        }
+        frame_.numChannels = byte;
+        channelIdx_ = 0;
+        step_ = Step::channelHigh;
+        break;
+    case Step::channelHigh:
+        // channels are big endian
+        frame_.channel[channelIdx_] = (uint16_t)(byte << 8);
+        step_ = Step::channelLow;
+        break;
+    case Step::channelLow:
+        frame_.channel[channelIdx_] |= byte;
+        channelIdx_++;
+        step_ = (channelIdx_ == frame_.numChannels) ? Step::crcHigh : Step::channelHigh;
+        break;
+    case Step::crcHigh:
+        frame_.crc = (uint16_t)(byte << 8);
+        frameLen_++;
+        step_ = Step::crcLow;
+        return false;
+    case Step::crcLow:
+        frame_.crc |= byte;
+        frameLen_++;
+        if (frame_.crc != crc_) {
+            crcErrors_++;
+            dropFrame();
+            return false;
+        }
+        step_ = Step::header;
+        frameLen_ = 0;
+        packet_ = frame_;
+        return true;
+    }
+    crc_ = crc16Update(crc_, byte);
+    frameLen_++;
+    return false;
+}
+
+bool SumdParser::startFrame(uint8_t byte) {
+    if (byte != MAN_ID) {
+        return false;
+    }
+    frame_.manufactureId = byte;
+    crc_ = crc16Update(0, byte);
+    frameLen_ = 1;
+    step_ = Step::status;
+    return true;
+}
+
+void SumdParser::dropFrame() {
+    skippedBytes_ += frameLen_;
+    frameLen_ = 0;
+    step_ = Step::header;
+}
@@ -0,0 +1,166 @@
+#include "telemetry.hpp"
+
+#include <cstring>
+
+static inline uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static inline void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+static inline bool getVarint(ByteSpan in, size_t& index, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (index >= in.size()) {
+            return false;
+        }
+        uint8_t b = in[index++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline void putLE(uint8_t* out, uint64_t v, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static inline uint64_t getLE(const uint8_t* in, size_t n) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        v |= (uint64_t)in[i] << (8 * i);
+    }
+    return v;
+}
+
+static void receiverFields(const ReceiverPacket& packet, int32_t* fields) {
+    // same scales as SR_RECEIVER
+    fields[0] = (int32_t)(packet.throttle * 65000);
+    fields[1] = (int32_t)(packet.steering * 65000);
+    fields[2] = (int32_t)packet.gearSelector;
+    fields[3] = (packet.lateral_control ? 1 : 0) | (packet.autonomous ? 2 : 0);
+}
+
+static void vescFields(const VescData& data, int32_t* fields) {
+    // same scales as SR_STATUS
+    fields[0] = (int32_t)(data.mosfet_temp * 10);
+    fields[1] = (int32_t)(data.motor_temp * 10);
+    fields[2] = data.rpm;
+    fields[3] = (int32_t)(data.voltage * 10);
+    fields[4] = data.ticks;
+    fields[5] = data.ticksAbs;
+}
+
+static void putFields(std::vector<uint8_t>& out, const int32_t* fields, int32_t* last, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        putVarint(out, zigzag((int64_t)fields[i] - last[i]));
+        last[i] = fields[i];
+    }
+}
+
+static bool getFields(ByteSpan in, size_t& index, int32_t* last, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t v;
+        if (!getVarint(in, index, v)) {
+            return false;
+        }
+        last[i] = (int32_t)(last[i] + unzigzag(v));
+    }
+    return true;
+}
+
+TelemetryEncoder::TelemetryEncoder(size_t maxSamples) : maxSamples_(maxSamples) {
+}
+
+void TelemetryEncoder::add(const TelemetrySample& sample, std::vector<uint8_t>& out) {
+    int64_t us = sample.timestampNs / 1000;
+    if (out.empty()) {
+        out.resize(TELEMETRY_HEADER_SIZE);
+        out[0] = TELEMETRY_VERSION;
+        out[1] = 0;
+        putLE(&out[4], (uint64_t)sample.timestampNs, 8);
+        samples_ = 0;
+        lastUs_ = us;
+        memset(lastReceiver_, 0, sizeof(lastReceiver_));
+        memset(lastVesc_, 0, sizeof(lastVesc_));
+    }
+    out.push_back((uint8_t)sample.kind);
+    putVarint(out, zigzag(us - lastUs_));
+    lastUs_ = us;
+    int32_t fields[6];
+    if (sample.kind == TelemetryKind::receiver) {
+        receiverFields(sample.receiver, fields);
+        putFields(out, fields, lastReceiver_, 4);
+    } else {
+        vescFields(sample.vesc, fields);
+        putFields(out, fields, lastVesc_, 6);
+    }
+    samples_++;
+    putLE(&out[2], samples_, 2);
+}
+
+bool decodeTelemetryFrame(ByteSpan frame, std::vector<TelemetrySample>& samples) {
+    samples.clear();
+    if (frame.size() < TELEMETRY_HEADER_SIZE || frame[0] != TELEMETRY_VERSION) {
+        return false;
+    }
+    size_t count = getLE(&frame[2], 2);
+    int64_t firstNs = (int64_t)getLE(&frame[4], 8);
+    int64_t us = firstNs / 1000;
+    int32_t receiver[4] = {};
+    int32_t vesc[6] = {};
+    size_t index = TELEMETRY_HEADER_SIZE;
+    for (size_t i = 0; i < count; i++) {
+        if (index >= frame.size()) {
+            return false;
+        }
+        TelemetrySample sample;
+        sample.kind = (TelemetryKind)frame[index++];
+        uint64_t delta;
+        if (!getVarint(frame, index, delta)) {
+            return false;
+        }
+        us += unzigzag(delta);
+        // the first sample keeps its full resolution
+        sample.timestampNs = i == 0 ? firstNs : us * 1000;
+        if (sample.kind == TelemetryKind::receiver) {
+            if (!getFields(frame, index, receiver, 4)) {
+                return false;
+            }
+            sample.receiver.throttle = receiver[0] / 65000.0f;
+            sample.receiver.steering = receiver[1] / 65000.0f;
+            sample.receiver.gearSelector = (ReceiverGear)receiver[2];
+            sample.receiver.lateral_control = receiver[3] & 1;
+            sample.receiver.autonomous = receiver[3] & 2;
+            sample.receiver.timestampNs = sample.timestampNs;
+        } else if (sample.kind == TelemetryKind::vesc) {
+            if (!getFields(frame, index, vesc, 6)) {
+                return false;
+            }
+            sample.vesc.mosfet_temp = vesc[0] / 10.0f;
+            sample.vesc.motor_temp = vesc[1] / 10.0f;
+            sample.vesc.rpm = vesc[2];
+            sample.vesc.voltage = vesc[3] / 10.0f;
+            sample.vesc.ticks = vesc[4];
+            sample.vesc.ticksAbs = vesc[5];
+        } else {
+            return false;
+        }
+        samples.push_back(sample);
+    }
+    return index == frame.size();
+}
@@ -0,0 +1,134 @@
+#include "vesc_frame.hpp"
+#include "crc.h"
+
+size_t vescEncodeFrame(ByteSpan payload, MutableByteSpan out) {
+    size_t len = payload.size();
+    size_t overhead = (len <= 255) ? VESC_FRAME_OVERHEAD_MAX - 1 : VESC_FRAME_OVERHEAD_MAX;
+    if (len == 0 || len > 0xFFFF || out.size() < len + overhead) {
+        return 0;
+    }
+    uint8_t* p = out.data();
+    if (len <= 255) {
+        *p++ = VESC_FRAME_START_SHORT;
+        *p++ = (uint8_t)len;
+    } else {
+        *p++ = VESC_FRAME_START_LONG;
+        *p++ = (uint8_t)(len >> 8);
+        *p++ = (uint8_t)(len & 0xFF);
+    }
+    memcpy(p, payload.data(), len);
+    p += len;
+    uint16_t crc = crc16(payload);
+    *p++ = (uint8_t)(crc >> 8);
+    *p++ = (uint8_t)(crc & 0xFF);
+    *p++ = VESC_FRAME_END;
+    return p - out.data();
+}
+
+VescFrameDecoder::VescFrameDecoder() : consumed_(0), crcErrors_(0), skippedBytes_(0) {}
+
+void VescFrameDecoder::skip(size_t count) {
+    buffer_.pop(count);
+    skippedBytes_ += count;
+}
+
+/// view on buffered bytes [offset, offset+len). Only copies if they wrap around the end of the ring
+ByteSpan VescFrameDecoder::contiguous(size_t offset, size_t len) {
+    RingBuffer<VESC_BUFFER_SIZE>::Spans spans = buffer_.peekContiguous();
+    size_t firstLen = spans.first.size();
+    if (offset + len <= firstLen) {
+        return spans.first.subspan(offset, len);
+    }
+    if (offset >= firstLen) {
+        return spans.second.subspan(offset - firstLen, len);
+    }
+    size_t head = firstLen - offset;
+    memcpy(frame_, spans.first.data() + offset, head);
+    memcpy(frame_ + head, spans.second.data(), len - head);
+    return ByteSpan(frame_, len);
+}
+
+/// checks the candidate starting at buffered byte offset, which has to be a start byte
+VescFrameDecoder::Candidate VescFrameDecoder::check(size_t offset, size_t avail, size_t& header, size_t& len) {
+    uint8_t start = buffer_[offset];
+    header = (start == VESC_FRAME_START_SHORT) ? 2 : 3;
+    if (avail - offset < header) {
+        return Candidate::incomplete;
+    }
+    len = (start == VESC_FRAME_START_SHORT) ? buffer_[offset + 1] : ((buffer_[offset + 1] << 8) | buffer_[offset + 2]);
+    if (len == 0 || len > VESC_PAYLOAD_MAXSIZE) {
+        return Candidate::invalid;
+    }
+    size_t total = header + len + 3;
+    if (avail - offset < total) {
+        return Candidate::incomplete;
+    }
+    // cheap checks first, the crc is only computed for candidates which end correctly
+    if (buffer_[offset + total - 1] != VESC_FRAME_END) {
+        return Candidate::invalid;
+    }
+    uint16_t crc = (uint16_t)((buffer_[offset + header + len] << 8) | buffer_[offset + header + len + 1]);
+    if (crc16(contiguous(offset + header, len)) != crc) {
+        return Candidate::badCrc;
+    }
+    return Candidate::valid;
+}
+
+/// offset of the first complete, valid frame behind the incomplete candidate at 0, 0 if there is none
+size_t VescFrameDecoder::findBehind(size_t avail) {
+    size_t header, len;
+    for (size_t offset = 1; offset + VESC_FRAME_OVERHEAD_MAX - 1 < avail; offset++) {
+        uint8_t start = buffer_[offset];
+        if ((start == VESC_FRAME_START_SHORT || start == VESC_FRAME_START_LONG) &&
+            check(offset, avail, header, len) == Candidate::valid) {
+            return offset;
+        }
+    }
+    return 0;
+}
+
+bool VescFrameDecoder::next(ByteSpan& payload) {
+    buffer_.pop(consumed_);
+    consumed_ = 0;
+
+    while (true) {
+        size_t avail = buffer_.available();
+        if (avail == 0) {
+            return false;
+        }
+        // throw away everything in front of the next start byte
+        uint8_t start = buffer_[0];
+        if (start != VESC_FRAME_START_SHORT && start != VESC_FRAME_START_LONG) {
+            size_t garbage = 1;
+            while (garbage < avail && buffer_[garbage] != VESC_FRAME_START_SHORT && buffer_[garbage] != VESC_FRAME_START_LONG) {
+                garbage++;
+            }
+            skip(garbage);
+            continue;
+        }
+        size_t header, len;
+        switch (check(0, avail, header, len)) {
+        case Candidate::incomplete: {
+            // a stray start byte may announce up to VESC_FRAME_MAXSIZE bytes. Instead of holding back the
+            // frames behind it until that many bytes arrived, drop it as soon as a valid frame follows
+            size_t next = findBehind(avail);
+            if (next == 0) {
+                return false;
+            }
+            skip(next);
+            continue;
+        }
+        case Candidate::invalid:
+            skip(1);
+            continue;
+        case Candidate::badCrc:
+            crcErrors_++;
+            skip(1);
+            continue;
+        case Candidate::valid:
+            payload = contiguous(header, len);
+            consumed_ = header + len + 3;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#include "vesc_poller.hpp"
+#include "clock.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+VescPoller::VescPoller(Reactor& reactor, Vesc& vesc, const Config& config)
+    : vesc_(vesc), config_(config), timer_(reactor.context()) {
+    double bytesPerSecond = config_.baud / 10.0; // 8N1
+    maxRate_ = std::min(bytesPerSecond * config_.txShare / VESC_POLL_REQUEST_FRAME_SIZE,
+                        bytesPerSecond * config_.rxShare / VESC_POLL_ANSWER_FRAME_SIZE);
+    rate_ = std::min(config_.idleRate, maxRate_);
+}
+
+void VescPoller::start() {
+    boost::asio::post(timer_.get_executor(), [this]() {
+        nextNs_ = monotonicNs();
+        rateGauge_.set((int64_t)rate_);
+        tick();
+    });
+}
+
+void VescPoller::schedule() {
+    // absolute deadlines, so the rate does not drift with the time a tick takes
+    nextNs_ += (int64_t)(1e9 / rate_);
+    int64_t now = monotonicNs();
+    if (nextNs_ < now) {
+        nextNs_ = now; // the reactor was busy, do not catch up
+    }
+    timer_.expires_after(std::chrono::nanoseconds(nextNs_ - now));
+    uint64_t generation = ++timerGeneration_;
+    timer_.async_wait([this, generation](const boost::system::error_code& error) {
+        if (!error && generation == timerGeneration_) {
+            tick();
+        }
+    });
+}
+
+void VescPoller::tick() {
+    int64_t now = monotonicNs();
+    // requests without an answer for too long are given up, their slot is free again
+    while (inFlightCount_ > 0 && now - inFlight_[inFlightHead_] > config_.timeout.count()) {
+        inFlightHead_ = (inFlightHead_ + 1) % VESC_POLL_MAX_IN_FLIGHT;
+        inFlightCount_--;
+        timeouts_.add();
+        lateExpected_++;
+        lateUntilNs_ = now + config_.timeout.count();
+    }
+
+    if (inFlightCount_ < VESC_POLL_MAX_IN_FLIGHT) {
+        // a request the tx queue could not take gets no answer, so it does not take a slot
+        if (vesc_.requestState()) {
+            inFlight_[(inFlightHead_ + inFlightCount_) % VESC_POLL_MAX_IN_FLIGHT] = now;
+            inFlightCount_++;
+            requests_.add();
+        }
+    } else {
+        skipped_.add();
+    }
+
+    double rate = now - lastMovingNs_ < config_.movingHold.count() ? config_.movingRate : config_.idleRate;
+    rate = std::min(rate, maxRate_);
+    if (rate != rate_) {
+        rate_ = rate;
+        rateGauge_.set((int64_t)rate_);
+    }
+    schedule();
+}
+
+void VescPoller::answered(const VescData& data) {
+    int64_t now = monotonicNs();
+    if (lateExpected_ > 0 && now >= lateUntilNs_) {
+        lateExpected_ = 0; // those answers got lost
+    }
+    if (lateExpected_ > 0) {
+        // answered in order, so this belongs to a given up request and not to the oldest waiting one
+        lateExpected_--;
+        late_.add();
+    } else if (inFlightCount_ == 0) {
+        unmatched_.add();
+    } else {
+        rtt_.record(now - inFlight_[inFlightHead_]);
+        inFlightHead_ = (inFlightHead_ + 1) % VESC_POLL_MAX_IN_FLIGHT;
+        inFlightCount_--;
+        answers_.add();
+    }
+    if (std::abs(data.rpm) > config_.movingRpm) {
+        bool wasIdle = now - lastMovingNs_ >= config_.movingHold.count();
+        lastMovingNs_ = now;
+        if (wasIdle) {
+            // speed up right away instead of waiting out the idle period
+            nextNs_ = now - (int64_t)(1e9 / rate_);
+            schedule();
+        }
+    }
+}
+
+VescPollerStats VescPoller::stats() const {
+    VescPollerStats stats;
+    stats.requests = requests_.value();
+    stats.answers = answers_.value();
+    stats.timeouts = timeouts_.value();
+    stats.late = late_.value();
+    stats.unmatched = unmatched_.value();
+    stats.rate = (double)rateGauge_.value();
+    return stats;
+}
@@ -0,0 +1,183 @@
+#include "vesc_tx.hpp"
+#include "clock.hpp"
+
+#include <algorithm>
+
+VescTxQueue::VescTxQueue(Reactor& reactor, Serial& ser, uint32_t baud, std::chrono::nanoseconds cycle)
+    : ser_(ser), freeCount_(VESC_TX_POOL_SIZE), pendingCount_(0), inFlightCount_(0), flushScheduled_(false), writing_(false),
+      bytesPerNs_(baud / 10.0 / 1e9), // 8N1
+      budget_(bytesPerNs_ * cycle.count()), tokens_(budget_), refilledNs_(monotonicNs()), budgetTimer_(reactor.context()) {
+    for (size_t i = 0; i < VESC_TX_POOL_SIZE; i++) {
+        free_[i] = (uint8_t)i;
+    }
+}
+
+bool VescTxQueue::send(ByteSpan payload, VescTxClass cls, bool latestWins) {
+    if (payload.empty()) {
+        return false;
+    }
+    uint8_t command = payload[0];
+    int64_t now = monotonicNs();
+    std::lock_guard<std::mutex> lock(m_);
+
+    bool queued = false;
+    if (latestWins) {
+        // overwrite the queued command in place; in its class it keeps its position and its queue time
+        for (Pending& pending : pending_) {
+            for (size_t i = 0; i < pending.count && !queued; i++) {
+                Slot& slot = slots_[pending.slots[i]];
+                if (!slot.latestWins || slot.command != command) {
+                    continue;
+                }
+                size_t len = vescEncodeFrame(payload, MutableByteSpan(slot.frame, sizeof(slot.frame)));
+                if (len == 0) {
+                    return false;
+                }
+                slot.len = len;
+                if (slot.cls != cls) {
+                    // e.g. a fail safe duty replaces a queued setpoint duty, which must not go out after it
+                    uint8_t idx = pending.slots[i];
+                    std::copy(pending.slots.begin() + i + 1, pending.slots.begin() + pending.count, pending.slots.begin() + i);
+                    pending.count--;
+                    Pending& target = pending_[(size_t)cls];
+                    target.slots[target.count++] = idx;
+                    slot.cls = cls;
+                    slot.queuedNs = now;
+                }
+                coalesced_.add();
+                queued = true;
+            }
+        }
+    }
+
+    if (!queued) {
+        if (freeCount_ == 0) {
+            dropped_.add();
+            return false;
+        }
+        uint8_t idx = free_[freeCount_ - 1];
+        Slot& slot = slots_[idx];
+        slot.len = vescEncodeFrame(payload, MutableByteSpan(slot.frame, sizeof(slot.frame)));
+        if (slot.len == 0) {
+            return false;
+        }
+        slot.command = command;
+        slot.latestWins = latestWins;
+        slot.cls = cls;
+        slot.queuedNs = now;
+        slot.deferred = false;
+        freeCount_--;
+        Pending& pending = pending_[(size_t)cls];
+        pending.slots[pending.count++] = idx;
+        pendingCount_++;
+        depth_.set(VESC_TX_POOL_SIZE - freeCount_);
+    }
+
+    if (!writing_ && !flushScheduled_) {
+        // posting (instead of writing right away) lets commands sent back to back end up in the same write.
+        // A command which moved up a class may now pass the budget, so coalesced ones post as well
+        flushScheduled_ = true;
+        ser_.post(std::bind(&VescTxQueue::flush, this));
+    }
+    return true;
+}
+
+/// runs on the reactor thread
+void VescTxQueue::flush() {
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        flushScheduled_ = false;
+        if (writing_ || pendingCount_ == 0) {
+            return;
+        }
+        int64_t now = monotonicNs();
+        tokens_ = std::min(budget_, tokens_ + (now - refilledNs_) * bytesPerNs_);
+        refilledNs_ = now;
+
+        // highest class first; once a frame waits for the budget, everything below it waits too
+        size_t heldBytes = 0;
+        for (size_t c = 0; c < (size_t)VescTxClass::count; c++) {
+            Pending& pending = pending_[c];
+            bool urgent = (VescTxClass)c <= VescTxClass::setpoint;
+            size_t taken = 0;
+            for (; taken < pending.count; taken++) {
+                Slot& slot = slots_[pending.slots[taken]];
+                // a frame larger than the budget goes out once the budget is full
+                if (!urgent && (heldBytes > 0 || tokens_ < std::min((double)slot.len, budget_))) {
+                    if (heldBytes == 0) {
+                        heldBytes = slot.len;
+                    }
+                    break;
+                }
+                tokens_ -= slot.len;
+                queueLatency_[c].record(now - slot.queuedNs);
+                inFlight_[count] = pending.slots[taken];
+                buffers_[count] = boost::asio::const_buffer(slot.frame, slot.len);
+                count++;
+            }
+            for (size_t i = taken; i < pending.count; i++) {
+                Slot& slot = slots_[pending.slots[i]];
+                if (!slot.deferred) {
+                    slot.deferred = true;
+                    deferred_.add();
+                }
+            }
+            std::copy(pending.slots.begin() + taken, pending.slots.begin() + pending.count, pending.slots.begin());
+            pending.count -= taken;
+        }
+        pendingCount_ -= count;
+        if (count == 0) {
+            armBudgetTimer(heldBytes);
+            return;
+        }
+        // whatever was held back is picked up by the flush after this write
+        inFlightCount_ = count;
+        writing_ = true;
+    }
+    writes_.add();
+    framesSent_.add(count);
+    ser_.asyncWrite(Span<const boost::asio::const_buffer>(buffers_.data(), count),
+                    std::bind(&VescTxQueue::handleWrite, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+void VescTxQueue::armBudgetTimer(size_t bytes) {
+    if (budgetTimerArmed_) {
+        return;
+    }
+    budgetTimerArmed_ = true;
+    double missing = std::min((double)bytes, budget_) - tokens_;
+    budgetTimer_.expires_after(std::chrono::nanoseconds((int64_t)(missing / bytesPerNs_) + 1));
+    budgetTimer_.async_wait([this](const boost::system::error_code& error) {
+        if (error) {
+            return; // reactor is shutting down
+        }
+        budgetTimerArmed_ = false;
+        flush();
+    });
+}
+
+/// runs on the reactor thread once all in flight frames are written
+void VescTxQueue::handleWrite(const boost::system::error_code& error, size_t bytes_transferred) {
+    if (error == boost::asio::error::operation_aborted) {
+        return; // port is shutting down
+    }
+    if (error) {
+        writeErrors_.add();
+    }
+    bytesSent_.add(bytes_transferred);
+    bool more;
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        for (size_t i = 0; i < inFlightCount_; i++) {
+            free_[freeCount_++] = inFlight_[i];
+        }
+        inFlightCount_ = 0;
+        writing_ = false;
+        depth_.set(VESC_TX_POOL_SIZE - freeCount_);
+        more = pendingCount_ > 0 && !flushScheduled_;
+    }
+    if (more) {
+        flush();
+    }
+}
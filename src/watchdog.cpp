@@ -0,0 +1,141 @@
+#include "watchdog.hpp"
+#include "log.hpp"
+#include "clock.hpp"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NSEC_PER_SEC 1000000000LL
+
+static inline timespec fromNs(int64_t ns) {
+    timespec ts;
+    ts.tv_sec = ns / NSEC_PER_SEC;
+    ts.tv_nsec = ns % NSEC_PER_SEC;
+    return ts;
+}
+
+Watchdog::Watchdog() {
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    stopFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || stopFd_ < 0) {
+        printf("Watchdog: could not create epoll/eventfd. Terminating.\n");
+        exit(1);
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = UINT64_MAX;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, stopFd_, &ev);
+}
+
+Watchdog::~Watchdog() {
+    stop();
+    for (auto& source : sources_) {
+        close(source->fd);
+    }
+    close(stopFd_);
+    close(epollFd_);
+}
+
+int Watchdog::addSource(std::chrono::nanoseconds timeout, std::function<void(void)> onTimeout) {
+    auto source = std::make_unique<Source>();
+    source->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (source->fd < 0) {
+        printf("Watchdog: could not create timerfd. Terminating.\n");
+        exit(1);
+    }
+    source->timeoutNs = timeout.count();
+    source->onTimeout = onTimeout;
+
+    int id = (int)sources_.size();
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = (uint64_t)id;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, source->fd, &ev);
+    sources_.push_back(std::move(source));
+    return id;
+}
+
+void Watchdog::start() {
+    if (active_.exchange(true)) {
+        return;
+    }
+    for (auto& source : sources_) {
+        arm(*source);
+    }
+    thread_ = std::thread(&Watchdog::run, this);
+}
+
+void Watchdog::stop() {
+    if (!active_.exchange(false)) {
+        return;
+    }
+    uint64_t one = 1;
+    if (write(stopFd_, &one, sizeof(one)) < 0) {
+        LOG_WARN(core, "Watchdog: could not signal stop");
+    }
+    if (thread_.joinable() && std::this_thread::get_id() != thread_.get_id()) {
+        thread_.join();
+    }
+}
+
+void Watchdog::feed(int source) {
+    arm(*sources_[source]);
+}
+
+void Watchdog::arm(Source& source) {
+    int64_t deadline = monotonicNs() + source.timeoutNs;
+    source.deadlineNs.store(deadline, std::memory_order_relaxed);
+    source.tripped.store(false, std::memory_order_relaxed);
+    // absolute first expiry, then keep firing every timeout while no heartbeat comes in
+    itimerspec spec{};
+    spec.it_value = fromNs(deadline);
+    spec.it_interval = fromNs(source.timeoutNs);
+    timerfd_settime(source.fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+WatchdogStats Watchdog::stats(int source) const {
+    const Source& s = *sources_[source];
+    WatchdogStats stats;
+    stats.trips = s.trips.load(std::memory_order_relaxed);
+    stats.lastLatencyNs = s.lastLatencyNs.load(std::memory_order_relaxed);
+    stats.maxLatencyNs = s.maxLatencyNs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void Watchdog::run() {
+    epoll_event events[8];
+    while (active_.load()) {
+        int n = epoll_wait(epollFd_, events, 8, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR(core, "Watchdog: epoll_wait failed");
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u64 == UINT64_MAX) {
+                return; // stop
+            }
+            Source& source = *sources_[events[i].data.u64];
+            uint64_t expirations;
+            // EAGAIN: a heartbeat re-armed the timer after it expired, so it is not timed out anymore
+            if (read(source.fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                continue;
+            }
+            if (!source.tripped.exchange(true, std::memory_order_relaxed)) {
+                int64_t latency = monotonicNs() - source.deadlineNs.load(std::memory_order_relaxed);
+                source.lastLatencyNs.store(latency, std::memory_order_relaxed);
+                if (latency > source.maxLatencyNs.load(std::memory_order_relaxed)) {
+                    source.maxLatencyNs.store(latency, std::memory_order_relaxed);
+                }
+            }
+            source.trips.fetch_add(1, std::memory_order_relaxed);
+            source.onTimeout();
+        }
+    }
+}